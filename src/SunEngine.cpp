@@ -0,0 +1,273 @@
+#include "SunEngine.h"
+#include <string.h>
+
+/***********************************
+ *
+ * Integer only sun calculation
+ *
+ * Angles are binary angles (2^32 = 360 degrees), so revolution() and
+ * rev180() are just unsigned/signed interpretations of the same value.
+ * Trigonometric values are Q30, days since 2000 Jan 0.0 are Q15 (this
+ * covers the years up to 2179). Sine is a quarter wave table with linear
+ * interpolation, atan2 is a CORDIC in vectoring mode, which delivers the
+ * radius (the sqrt of the original code) for free.
+ *
+ * *********************************/
+
+// compile time conversions, there is no floating point at runtime
+#define BAM(deg) ((SunEngineFixed::angle_t)(int64_t)((deg) / 360.0 * 4294967296.0))
+#define BAM_PER_DAY(deg) ((int64_t)((deg) / 360.0 * 4294967296.0 * 32768.0))
+#define Q30(x) ((int32_t)((x) * 1073741824.0))
+
+// sin(i * 90 / 256 degrees) in Q30
+static const int32_t cSinTable[257] = {
+    0, 6588356, 13176464, 19764076, 26350943, 32936819, 39521455, 46104602,
+    52686014, 59265442, 65842639, 72417357, 78989349, 85558366, 92124163, 98686491,
+    105245103, 111799753, 118350194, 124896179, 131437462, 137973796, 144504935, 151030634,
+    157550647, 164064728, 170572633, 177074115, 183568930, 190056834, 196537583, 203010932,
+    209476638, 215934457, 222384147, 228825464, 235258165, 241682010, 248096755, 254502159,
+    260897982, 267283981, 273659918, 280025552, 286380643, 292724951, 299058239, 305380268,
+    311690799, 317989595, 324276419, 330551034, 336813204, 343062693, 349299266, 355522689,
+    361732726, 367929144, 374111709, 380280190, 386434353, 392573967, 398698801, 404808624,
+    410903207, 416982319, 423045732, 429093217, 435124548, 441139496, 447137835, 453119340,
+    459083786, 465030947, 470960600, 476872522, 482766489, 488642281, 494499676, 500338453,
+    506158392, 511959275, 517740883, 523502998, 529245404, 534967884, 540670223, 546352205,
+    552013618, 557654248, 563273883, 568872310, 574449320, 580004702, 585538248, 591049748,
+    596538995, 602005783, 607449906, 612871159, 618269338, 623644239, 628995660, 634323400,
+    639627258, 644907034, 650162530, 655393548, 660599890, 665781362, 670937767, 676068911,
+    681174602, 686254647, 691308855, 696337036, 701339000, 706314559, 711263525, 716185713,
+    721080937, 725949013, 730789757, 735602987, 740388522, 745146182, 749875788, 754577161,
+    759250125, 763894504, 768510122, 773096806, 777654384, 782182683, 786681534, 791150767,
+    795590213, 799999706, 804379079, 808728167, 813046808, 817334838, 821592095, 825818421,
+    830013654, 834177638, 838310216, 842411232, 846480531, 850517961, 854523370, 858496606,
+    862437520, 866345964, 870221790, 874064853, 877875009, 881652112, 885396022, 889106597,
+    892783698, 896427186, 900036924, 903612776, 907154608, 910662286, 914135678, 917574653,
+    920979082, 924348837, 927683790, 930983817, 934248793, 937478595, 940673101, 943832191,
+    946955747, 950043650, 953095785, 956112036, 959092290, 962036435, 964944360, 967815955,
+    970651112, 973449725, 976211688, 978936898, 981625251, 984276646, 986890984, 989468165,
+    992008094, 994510675, 996975812, 999403415, 1001793390, 1004145648, 1006460100, 1008736660,
+    1010975242, 1013175761, 1015338134, 1017462281, 1019548121, 1021595575, 1023604567, 1025575020,
+    1027506862, 1029400018, 1031254418, 1033069992, 1034846671, 1036584389, 1038283080, 1039942680,
+    1041563127, 1043144360, 1044686319, 1046188946, 1047652185, 1049075980, 1050460278, 1051805027,
+    1053110176, 1054375676, 1055601479, 1056787540, 1057933813, 1059040255, 1060106826, 1061133483,
+    1062120190, 1063066909, 1063973603, 1064840240, 1065666786, 1066453210, 1067199483, 1067905576,
+    1068571464, 1069197120, 1069782521, 1070327646, 1070832474, 1071296985, 1071721163, 1072104991,
+    1072448455, 1072751542, 1073014240, 1073236540, 1073418433, 1073559913, 1073660973, 1073721611,
+    1073741824};
+
+// atan(2^-i) as binary angle
+static const uint32_t cAtanTable[30] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+    2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+    10430, 5215, 2608, 1304, 652, 326, 163, 81,
+    41, 20, 10, 5, 3, 1};
+
+// 1 / CORDIC gain in Q30
+static const int32_t cCordicGainInv = 652032874;
+// binary angle units per radian
+static const int64_t cBamPerRadian = 683565276;
+
+// binary angle units per degree in Q8
+static const int64_t cBamPerDegreeQ8 = 3054198966LL;
+
+int64_t SunEngineFixed::fromDegree(float iDegree)
+{
+    // decode the IEEE 754 value, so no soft float is called
+    uint32_t lBits;
+    memcpy(&lBits, &iDegree, sizeof(lBits));
+    int32_t lExponent = (int32_t)((lBits >> 23) & 0xFF);
+    // zero and denormals, infinity and NaN are no angles
+    if (lExponent == 0 || lExponent == 0xFF)
+        return 0;
+    // value = mantissa * 2^(exponent - 150), product is below 2^56
+    int64_t lResult = (int64_t)((lBits & 0x7FFFFFUL) | 0x800000UL) * cBamPerDegreeQ8;
+    int32_t lShift = lExponent - 150 - 8;
+    if (lShift >= 0)
+        lResult = (lShift > 6) ? INT64_MAX >> 1 : lResult << lShift;
+    else if (lShift > -63)
+        lResult = (lResult + (1LL << (-lShift - 1))) >> -lShift;
+    else
+        lResult = 0;
+    return (lBits & 0x80000000UL) ? -lResult : lResult;
+}
+
+int32_t SunEngineFixed::sinQ30(angle_t x)
+{
+    // position within the quadrant, mirrored for 2nd and 4th quadrant
+    uint32_t lPos = x & 0x3FFFFFFFUL;
+    if (x & 0x40000000UL)
+        lPos = 0x40000000UL - lPos;
+    uint32_t lIndex = lPos >> 22;
+    int32_t lResult = cSinTable[256];
+    if (lIndex < 256)
+        lResult = cSinTable[lIndex] + (int32_t)(((int64_t)(cSinTable[lIndex + 1] - cSinTable[lIndex]) * ((lPos >> 6) & 0xFFFF)) >> 16);
+    return (x & 0x80000000UL) ? -lResult : lResult;
+}
+
+SunEngineFixed::angle_t SunEngineFixed::atan2Q30(int32_t y, int32_t x, int32_t *eRadius)
+{
+    angle_t lAngle = 0;
+    // one bit headroom for the CORDIC gain of 1.647
+    int32_t lX = x >> 1;
+    int32_t lY = y >> 1;
+    // CORDIC converges just for the right half plane
+    if (lX < 0)
+    {
+        lAngle = 0x80000000UL;
+        lX = -lX;
+        lY = -lY;
+    }
+    for (uint8_t i = 0; i < 30; i++)
+    {
+        int32_t lTemp = lX;
+        if (lY > 0)
+        {
+            lX += lY >> i;
+            lY -= lTemp >> i;
+            lAngle += cAtanTable[i];
+        }
+        else
+        {
+            lX -= lY >> i;
+            lY += lTemp >> i;
+            lAngle -= cAtanTable[i];
+        }
+    }
+    if (eRadius)
+        *eRadius = mulQ30(lX, cCordicGainInv) << 1;
+    return lAngle;
+}
+
+uint32_t SunEngineFixed::isqrt(uint64_t x)
+{
+    uint64_t lResult = 0;
+    uint64_t lBit = 1ULL << 62;
+    while (lBit > x)
+        lBit >>= 2;
+    while (lBit)
+    {
+        if (x >= lResult + lBit)
+        {
+            x -= lResult + lBit;
+            lResult = (lResult >> 1) + lBit;
+        }
+        else
+            lResult >>= 1;
+        lBit >>= 2;
+    }
+    return (uint32_t)lResult;
+}
+
+// iBase + iRate * d, iRate in binary angle per day in Q15, d in Q15
+SunEngineFixed::angle_t SunEngineFixed::linear(angle_t iBase, int64_t iRate, int32_t d)
+{
+    int64_t lDays = d >> 15;
+    int64_t lFraction = d & 0x7FFF;
+    return iBase + (angle_t)((lDays * iRate) >> 15) + (angle_t)((lFraction * iRate) >> 30);
+}
+
+int SunEngineFixed::sunRiseSet(int year, int month, int day, float lon, float lat,
+                               float altit, int upper_limb, int16_t *trise, int16_t *tset)
+{
+    Day lDay;
+    sunDay(year, month, day, lon, &lDay);
+    return sunRiseSet(lDay, lat, altit, upper_limb, trise, tset);
+}
+
+void SunEngineFixed::sunDay(int year, int month, int day, float lon, Day *eDay)
+{
+    int64_t lLon = fromDegree(lon);
+    angle_t sRA;
+
+    /* Compute d of 12h local mean solar time, lon / 360 is the binary angle itself */
+    /* lLon is signed and not reduced here, +180 degrees is half a day back         */
+    int32_t d = ((int32_t)days_since_2000_Jan_0(year, month, day) << 15) + 0x4000 - (int32_t)(lLon >> 17);
+
+    /* Compute the local sidereal time of this moment */
+    angle_t sidtime = GMST0(d) + BAM(180.0) + (angle_t)lLon;
+
+    /* Compute Sun's RA, Decl and distance at this moment */
+    sunRadDec(d, &sRA, &eDay->sdec, &eDay->sr);
+
+    /* Compute time when Sun is at south as fraction of the day (2^32 = 24h) */
+    /* 15 degrees per hour makes a binary hour angle identical to this unit  */
+    eDay->tsouth = 0x80000000LL - (int32_t)(sidtime - sRA);
+}
+
+int SunEngineFixed::sunRiseSet(const Day &iDay, float lat, float altit, int upper_limb, int16_t *trise, int16_t *tset)
+{
+    angle_t lLat = (angle_t)fromDegree(lat);
+    angle_t lAltit = (angle_t)fromDegree(altit);
+    int64_t t;
+    int rc = 0;
+
+    /* Do correction to upper limb, if necessary */
+    if (upper_limb)
+        lAltit -= (angle_t)(((int64_t)BAM(0.2666) << 30) / iDay.sr);
+
+    /* Compute the diurnal arc that the Sun traverses to reach */
+    /* the specified altitude altit, cos(lat) * cos(sdec) >= 0 */
+    int32_t lNum = sinQ30(lAltit) - mulQ30(sinQ30(lLat), sinQ30(iDay.sdec));
+    int32_t lDen = mulQ30(cosQ30(lLat), cosQ30(iDay.sdec));
+    if (lNum >= lDen)
+        rc = -1, t = 0; /* Sun always below altit */
+    else if (lNum <= -lDen)
+        rc = +1, t = 0x80000000LL; /* Sun always above altit */
+    else
+    {
+        int32_t cost = (int32_t)(((int64_t)lNum << 30) / lDen);
+        int32_t sint = isqrt((uint64_t)((int64_t)cOne * cOne - (int64_t)cost * cost));
+        t = atan2Q30(sint, cost); /* The diurnal arc */
+    }
+
+    /* Store rise and set times - in minutes UT */
+    *trise = (int16_t)(((iDay.tsouth - t) * 1440) >> 32);
+    *tset = (int16_t)(((iDay.tsouth + t) * 1440) >> 32);
+
+    return rc;
+}
+
+void SunEngineFixed::sunPos(int32_t d, angle_t *lon, int32_t *r)
+{
+    /* Compute mean elements */
+    angle_t M = linear(BAM(356.0470), BAM_PER_DAY(0.9856002585), d);
+    angle_t w = linear(BAM(282.9404), BAM_PER_DAY(4.70935E-5), d);
+    int32_t e = Q30(0.016709) - (int32_t)(((int64_t)d * (int64_t)(1.151E-9 * 140737488355328.0)) >> 32);
+
+    /* Compute true longitude and radius vector */
+    int32_t lTerm = mulQ30(e, mulQ30(sinQ30(M), cOne + mulQ30(e, cosQ30(M))));
+    angle_t E = M + (angle_t)(int32_t)(((int64_t)lTerm * cBamPerRadian) >> 30);
+    int32_t x = cosQ30(E) - e;
+    int32_t y = mulQ30(cOne - (mulQ30(e, e) >> 1), sinQ30(E));
+    angle_t v = atan2Q30(y, x, r); /* True anomaly and solar distance */
+    *lon = v + w;                  /* True solar longitude */
+}
+
+void SunEngineFixed::sunRadDec(int32_t d, angle_t *RA, angle_t *dec, int32_t *r)
+{
+    angle_t lon;
+    int32_t rho;
+
+    /* Compute Sun's ecliptical coordinates */
+    sunPos(d, &lon, r);
+
+    /* Compute ecliptic rectangular coordinates (z=0) */
+    int32_t x = mulQ30(*r, cosQ30(lon));
+    int32_t y = mulQ30(*r, sinQ30(lon));
+
+    /* Compute obliquity of ecliptic (inclination of Earth's axis) */
+    angle_t obl_ecl = linear(BAM(23.4393), BAM_PER_DAY(-3.563E-7), d);
+
+    /* Convert to equatorial rectangular coordinates - x is unchanged */
+    int32_t z = mulQ30(y, sinQ30(obl_ecl));
+    y = mulQ30(y, cosQ30(obl_ecl));
+
+    /* Convert to spherical coordinates */
+    *RA = atan2Q30(y, x, &rho);
+    *dec = atan2Q30(z, rho);
+}
+
+SunEngineFixed::angle_t SunEngineFixed::GMST0(int32_t d)
+{
+    return linear(BAM(180.0 + 356.0470 + 282.9404), BAM_PER_DAY(0.9856002585 + 4.70935E-5), d);
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+/***********************************
+ *
+ * Sun calculations, based on sunriset.c by Paul Schlyter
+ *
+ * SunEngine<double> and SunEngine<float> run the original algorithm in
+ * the given floating point type. SunEngineFixed is an integer only
+ * implementation using binary angles (full circle = 2^32), Q30 values
+ * and table/CORDIC based trigonometry for MCUs without FPU.
+ *
+ * TimerModule uses double by default, define TIMER_SUN_FLOAT or
+ * TIMER_SUN_FIXED to select one of the other variants.
+ *
+ * *********************************/
+
+#include <stdint.h>
+#include <math.h>
+#include <cmath>
+
+/* A macro to compute the number of days elapsed since 2000 Jan 0.0 */
+/* (which is equal to 1999 Dec 31, 0h UT)                           */
+
+#define days_since_2000_Jan_0(y, m, d) \
+    (367L * (y) - ((7 * ((y) + (((m) + 9) / 12))) / 4) + ((275 * (m)) / 9) + (d)-730530L)
+
+template <typename T>
+class SunEngine
+{
+  public:
+    // terms of a day, which are shared by all altitudes
+    struct Day
+    {
+        T tsouth; /* Time when Sun is at south, hours UT */
+        T sdec;   /* Sun's declination */
+        T sr;     /* Solar distance, astronomical units */
+    };
+
+    static int sunRiseSet(int year, int month, int day, T lon, T lat,
+                          T altit, int upper_limb, T *rise, T *set);
+    static void sunDay(int year, int month, int day, T lon, Day *eDay);
+    static int sunRiseSet(const Day &iDay, T lat, T altit, int upper_limb, T *rise, T *set);
+    static void sunPos(T d, T *lon, T *r);
+    static void sunRadDec(T d, T *RA, T *dec, T *r);
+    static T revolution(T x);
+    static T rev180(T x);
+    static T GMST0(T d);
+    static void horizontal(T ha, T dec, T lat, T *azimuth, T *elevation);
+
+  private:
+    /* Some conversion factors between radians and degrees */
+    static constexpr T cRadeg = T(57.295779513082320877);
+    static constexpr T cDegrad = T(0.017453292519943295769);
+    static constexpr T cInv360 = T(1.0 / 360.0);
+
+    /* The trigonometric functions in degrees */
+    static T sinDeg(T x) { return std::sin(x * cDegrad); }
+    static T cosDeg(T x) { return std::cos(x * cDegrad); }
+    static T acosDeg(T x) { return cRadeg * std::acos(x); }
+    static T atan2Deg(T y, T x) { return cRadeg * std::atan2(y, x); }
+};
+
+class SunEngineFixed
+{
+  public:
+    // binary angle, 2^32 is a full circle, so reduction to 0..360 degrees is free
+    typedef uint32_t angle_t;
+    static const int32_t cOne = 1L << 30; // 1.0 in Q30
+
+    // terms of a day, which are shared by all altitudes
+    struct Day
+    {
+        int64_t tsouth; // time when Sun is at south as fraction of the day (2^32 = 24h)
+        angle_t sdec;   // Sun's declination
+        int32_t sr;     // solar distance in Q30
+    };
+
+    // rise and set are returned in UT minutes of day
+    static int sunRiseSet(int year, int month, int day, float lon, float lat,
+                          float altit, int upper_limb, int16_t *rise, int16_t *set);
+    static void sunDay(int year, int month, int day, float lon, Day *eDay);
+    static int sunRiseSet(const Day &iDay, float lat, float altit, int upper_limb, int16_t *rise, int16_t *set);
+    // d is the day number since 2000 Jan 0.0 in Q15, r is returned in Q30
+    static void sunPos(int32_t d, angle_t *lon, int32_t *r);
+    static void sunRadDec(int32_t d, angle_t *RA, angle_t *dec, int32_t *r);
+    static angle_t GMST0(int32_t d);
+
+    // signed binary angle, not reduced to a full circle, by integer operations only
+    static int64_t fromDegree(float iDegree);
+    static int32_t sinQ30(angle_t x);
+    static int32_t cosQ30(angle_t x) { return sinQ30(x + 0x40000000UL); }
+    static angle_t atan2Q30(int32_t y, int32_t x, int32_t *eRadius = nullptr);
+
+  private:
+    static int32_t mulQ30(int32_t a, int32_t b) { return (int32_t)(((int64_t)a * b) >> 30); }
+    static angle_t linear(angle_t iBase, int64_t iRate, int32_t d);
+    static uint32_t isqrt(uint64_t x);
+};
+
+/***************************************************************************/
+/* Note: year,month,date = calendar date, 1801-2099 only.             */
+/*       Eastern longitude positive, Western longitude negative       */
+/*       Northern latitude positive, Southern latitude negative       */
+/*       The longitude value IS critical in this function!            */
+/*       altit = the altitude which the Sun should cross              */
+/*               Set to -35/60 degrees for rise/set, -6 degrees       */
+/*               for civil, -12 degrees for nautical and -18          */
+/*               degrees for astronomical twilight.                   */
+/*         upper_limb: non-zero -> upper limb, zero -> center         */
+/*               Set to non-zero (e.g. 1) when computing rise/set     */
+/*               times, and to zero when computing start/end of       */
+/*               twilight.                                            */
+/*        *rise = where to store the rise time                        */
+/*        *set  = where to store the set  time                        */
+/*                Both times are relative to the specified altitude,  */
+/*                and thus this function can be used to compute       */
+/*                various twilight times, as well as rise/set times   */
+/* Return value:  0 = sun rises/sets this day, times stored at        */
+/*                    *trise and *tset.                               */
+/*               +1 = sun above the specified "horizon" 24 hours.     */
+/*                    *trise set to time when the sun is at south,    */
+/*                    minus 12 hours while *tset is set to the south  */
+/*                    time plus 12 hours. "Day" length = 24 hours     */
+/*               -1 = sun is below the specified "horizon" 24 hours   */
+/*                    "Day" length = 0 hours, *trise and *tset are    */
+/*                    both set to the time when the sun is at south.  */
+/*                                                                    */
+/**********************************************************************/
+template <typename T>
+int SunEngine<T>::sunRiseSet(int year, int month, int day, T lon, T lat,
+                             T altit, int upper_limb, T *trise, T *tset)
+{
+    Day lDay;
+    sunDay(year, month, day, lon, &lDay);
+    return sunRiseSet(lDay, lat, altit, upper_limb, trise, tset);
+}
+
+/* The altitude independent part of sunRiseSet() */
+template <typename T>
+void SunEngine<T>::sunDay(int year, int month, int day, T lon, Day *eDay)
+{
+    T d,         /* Days since 2000 Jan 0.0 (negative before) */
+        sRA,     /* Sun's Right Ascension */
+        sidtime; /* Local sidereal time */
+
+    /* Compute d of 12h local mean solar time */
+    d = days_since_2000_Jan_0(year, month, day) + T(0.5) - lon / T(360.0);
+
+    /* Compute the local sidereal time of this moment */
+    sidtime = revolution(GMST0(d) + T(180.0) + lon);
+
+    /* Compute Sun's RA, Decl and distance at this moment */
+    sunRadDec(d, &sRA, &eDay->sdec, &eDay->sr);
+
+    /* Compute time when Sun is at south - in hours UT */
+    eDay->tsouth = T(12.0) - rev180(sidtime - sRA) / T(15.0);
+}
+
+/* The altitude dependant part of sunRiseSet() */
+template <typename T>
+int SunEngine<T>::sunRiseSet(const Day &iDay, T lat, T altit, int upper_limb, T *trise, T *tset)
+{
+    T sradius, /* Sun's apparent radius */
+        t;     /* Diurnal arc */
+
+    int rc = 0; /* Return cde from function - usually 0 */
+
+    /* Compute the Sun's apparent radius in degrees */
+    sradius = T(0.2666) / iDay.sr;
+
+    /* Do correction to upper limb, if necessary */
+    if (upper_limb)
+        altit -= sradius;
+
+    /* Compute the diurnal arc that the Sun traverses to reach */
+    /* the specified altitude altit: */
+    {
+        T cost;
+        cost = (sinDeg(altit) - sinDeg(lat) * sinDeg(iDay.sdec)) /
+               (cosDeg(lat) * cosDeg(iDay.sdec));
+        if (cost >= T(1.0))
+            rc = -1, t = T(0.0); /* Sun always below altit */
+        else if (cost <= T(-1.0))
+            rc = +1, t = T(12.0); /* Sun always above altit */
+        else
+            t = acosDeg(cost) / T(15.0); /* The diurnal arc, hours */
+    }
+
+    /* Store rise and set times - in hours UT */
+    *trise = iDay.tsouth - t;
+    *tset = iDay.tsouth + t;
+
+    return rc;
+}
+
+/******************************************************/
+/* Computes the Sun's ecliptic longitude and distance */
+/* at an instant given in d, number of days since     */
+/* 2000 Jan 0.0.  The Sun's ecliptic latitude is not  */
+/* computed, since it's always very near 0.           */
+/******************************************************/
+template <typename T>
+void SunEngine<T>::sunPos(T d, T *lon, T *r)
+{
+    T M,      /* Mean anomaly of the Sun */
+        w,    /* Mean longitude of perihelion */
+              /* Note: Sun's mean longitude = M + w */
+        e,    /* Eccentricity of Earth's orbit */
+        E,    /* Eccentric anomaly */
+        x, y, /* x, y coordinates in orbit */
+        v;    /* True anomaly */
+
+    /* Compute mean elements */
+    M = revolution(T(356.0470) + T(0.9856002585) * d);
+    w = T(282.9404) + T(4.70935E-5) * d;
+    e = T(0.016709) - T(1.151E-9) * d;
+
+    /* Compute true longitude and radius vector */
+    E = M + e * cRadeg * sinDeg(M) * (T(1.0) + e * cosDeg(M));
+    x = cosDeg(E) - e;
+    y = std::sqrt(T(1.0) - e * e) * sinDeg(E);
+    *r = std::sqrt(x * x + y * y); /* Solar distance */
+    v = atan2Deg(y, x);            /* True anomaly */
+    *lon = v + w;                  /* True solar longitude */
+    if (*lon >= T(360.0))
+        *lon -= T(360.0); /* Make it 0..360 degrees */
+}
+
+/******************************************************/
+/* Computes the Sun's equatorial coordinates RA, Decl */
+/* and also its distance, at an instant given in d,   */
+/* the number of days since 2000 Jan 0.0.             */
+/******************************************************/
+template <typename T>
+void SunEngine<T>::sunRadDec(T d, T *RA, T *dec, T *r)
+{
+    T lon, obl_ecl, x, y, z;
+
+    /* Compute Sun's ecliptical coordinates */
+    sunPos(d, &lon, r);
+
+    /* Compute ecliptic rectangular coordinates (z=0) */
+    x = *r * cosDeg(lon);
+    y = *r * sinDeg(lon);
+
+    /* Compute obliquity of ecliptic (inclination of Earth's axis) */
+    obl_ecl = T(23.4393) - T(3.563E-7) * d;
+
+    /* Convert to equatorial rectangular coordinates - x is unchanged */
+    z = y * sinDeg(obl_ecl);
+    y = y * cosDeg(obl_ecl);
+
+    /* Convert to spherical coordinates */
+    *RA = atan2Deg(y, x);
+    *dec = atan2Deg(z, std::sqrt(x * x + y * y));
+}
+
+/**********************************************************/
+/* Converts hour angle and declination to azimuth (from   */
+/* north over east) and elevation (without refraction) at */
+/* the latitude lat, all in degrees                       */
+/**********************************************************/
+template <typename T>
+void SunEngine<T>::horizontal(T ha, T dec, T lat, T *azimuth, T *elevation)
+{
+    T sinDec = sinDeg(dec), cosDec = cosDeg(dec);
+    T sinLat = sinDeg(lat), cosLat = cosDeg(lat);
+    T cosHa = cosDeg(ha);
+    *elevation = cRadeg * std::asin(sinLat * sinDec + cosLat * cosDec * cosHa);
+    *azimuth = revolution(atan2Deg(-sinDeg(ha) * cosDec, cosLat * sinDec - sinLat * cosDec * cosHa));
+}
+
+/*****************************************/
+/* Reduce angle to within 0..360 degrees */
+/*****************************************/
+template <typename T>
+T SunEngine<T>::revolution(T x)
+{
+    return (x - T(360.0) * std::floor(x * cInv360));
+}
+
+/*********************************************/
+/* Reduce angle to within +180..+180 degrees */
+/*********************************************/
+template <typename T>
+T SunEngine<T>::rev180(T x)
+{
+    return (x - T(360.0) * std::floor(x * cInv360 + T(0.5)));
+}
+
+/*******************************************************************/
+/* This function computes GMST0, the Greenwich Mean Sidereal Time  */
+/* at 0h UT (i.e. the sidereal time at the Greenwhich meridian at  */
+/* 0h UT).  GMST is then the sidereal time at Greenwich at any     */
+/* time of the day.  I've generalized GMST0 as well, and define it */
+/* as:  GMST0 = GMST - UT  --  this allows GMST0 to be computed at */
+/* other times than 0h UT as well.  While this sounds somewhat     */
+/* contradictory, it is very practical:  instead of computing      */
+/* GMST like:                                                      */
+/*                                                                 */
+/*  GMST = (GMST0) + UT * (366.2422/365.2422)                      */
+/*                                                                 */
+/* where (GMST0) is the GMST last time UT was 0 hours, one simply  */
+/* computes:                                                       */
+/*                                                                 */
+/*  GMST = GMST0 + UT                                              */
+/*                                                                 */
+/* where GMST0 is the GMST "at 0h UT" but at the current moment!   */
+/* Defined in this way, GMST0 will increase with about 4 min a     */
+/* day.  It also happens that GMST0 (in degrees, 1 hr = 15 degr)   */
+/* is equal to the Sun's mean longitude plus/minus 180 degrees!    */
+/* (if we neglect aberration, which amounts to 20 seconds of arc   */
+/* or 1.33 seconds of time)                                        */
+/*                                                                 */
+/*******************************************************************/
+template <typename T>
+T SunEngine<T>::GMST0(T d)
+{
+    T sidtim0;
+    /* Sidtime at 0h UT = L (Sun's mean longitude) + 180.0 degr  */
+    /* L = M + w, as defined in sunpos().  Since I'm too lazy to */
+    /* add these numbers, I'll let the C compiler do it for me.  */
+    /* Any decent C compiler will add the constants at compile   */
+    /* time, imposing no runtime or code overhead.               */
+    sidtim0 = revolution(T(180.0 + 356.0470 + 282.9404) +
+                         T(0.9856002585 + 4.70935E-5) * d);
+    return sidtim0;
+} /* GMST0 */
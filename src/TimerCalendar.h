@@ -0,0 +1,120 @@
+#pragma once
+
+/***********************************
+ *
+ * Calendar arithmetic without mktime()
+ *
+ * Days are counted from 1970-01-01 (day number 0, a thursday).
+ * Months are 1..12, weekdays 0..6 with sunday = 0 (like struct tm).
+ *
+ * *********************************/
+
+#include <stdint.h>
+
+namespace TimerCalendar
+{
+    constexpr bool isLeapYear(int16_t iYear)
+    {
+        return (iYear % 4 == 0 && iYear % 100 != 0) || iYear % 400 == 0;
+    }
+
+    constexpr uint8_t daysInMonth(int16_t iYear, uint8_t iMonth)
+    {
+        return (iMonth == 2) ? (isLeapYear(iYear) ? 29 : 28) : ((iMonth == 4 || iMonth == 6 || iMonth == 9 || iMonth == 11) ? 30 : 31);
+    }
+
+    constexpr uint16_t daysInYear(int16_t iYear)
+    {
+        return isLeapYear(iYear) ? 366 : 365;
+    }
+
+    // day number of the given date, iDay may exceed the month in both directions
+    // (i.e. day 0 is the last day of the previous month)
+    constexpr int32_t daysFromCivil(int16_t iYear, uint8_t iMonth, int16_t iDay)
+    {
+        // see http://howardhinnant.github.io/date_algorithms.html
+        int32_t lYear = iYear - (iMonth <= 2);
+        int32_t lEra = (lYear >= 0 ? lYear : lYear - 399) / 400;
+        uint32_t lYearOfEra = (uint32_t)(lYear - lEra * 400);
+        int32_t lDayOfYear = (153 * (iMonth + (iMonth > 2 ? -3 : 9)) + 2) / 5 + iDay - 1;
+        int32_t lDayOfEra = lYearOfEra * 365 + lYearOfEra / 4 - lYearOfEra / 100 + lDayOfYear;
+        return lEra * 146097 + lDayOfEra - 719468;
+    }
+
+    constexpr void civilFromDays(int32_t iDays, int16_t &eYear, uint8_t &eMonth, uint8_t &eDay)
+    {
+        iDays += 719468;
+        int32_t lEra = (iDays >= 0 ? iDays : iDays - 146096) / 146097;
+        uint32_t lDayOfEra = (uint32_t)(iDays - lEra * 146097);
+        uint32_t lYearOfEra = (lDayOfEra - lDayOfEra / 1460 + lDayOfEra / 36524 - lDayOfEra / 146096) / 365;
+        uint32_t lDayOfYear = lDayOfEra - (365 * lYearOfEra + lYearOfEra / 4 - lYearOfEra / 100);
+        uint32_t lMonth = (5 * lDayOfYear + 2) / 153;
+        eDay = lDayOfYear - (153 * lMonth + 2) / 5 + 1;
+        eMonth = lMonth < 10 ? lMonth + 3 : lMonth - 9;
+        eYear = (int16_t)(lYearOfEra + lEra * 400 + (eMonth <= 2));
+    }
+
+    constexpr uint8_t weekday(int32_t iDays)
+    {
+        return (uint8_t)(iDays >= -4 ? (iDays + 4) % 7 : (iDays + 5) % 7 + 6);
+    }
+
+    // 0 based day of year (like tm_yday)
+    constexpr uint16_t dayOfYear(int16_t iYear, uint8_t iMonth, uint8_t iDay)
+    {
+        return (uint16_t)(daysFromCivil(iYear, iMonth, iDay) - daysFromCivil(iYear, 1, 1));
+    }
+
+    // day number of the iWeek-th (1..4, 5 = last) iWeekday (0 = sunday) in the given month
+    constexpr int32_t nthWeekday(int16_t iYear, uint8_t iMonth, uint8_t iWeek, uint8_t iWeekday)
+    {
+        if (iWeek >= 5)
+        {
+            int32_t lLast = daysFromCivil(iYear, iMonth, daysInMonth(iYear, iMonth));
+            return lLast - (weekday(lLast) - iWeekday + 7) % 7;
+        }
+        int32_t lFirst = daysFromCivil(iYear, iMonth, 1);
+        return lFirst + (iWeekday - weekday(lFirst) + 7) % 7 + (iWeek - 1) * 7;
+    }
+
+    // ISO 8601 week (1..53), the thursday of the week decides about the year
+    constexpr uint8_t isoWeek(int32_t iDays)
+    {
+        int32_t lThursday = iDays - (weekday(iDays) + 6) % 7 + 3;
+        int16_t lYear = 0;
+        uint8_t lMonth = 0, lDay = 0;
+        civilFromDays(lThursday, lYear, lMonth, lDay);
+        return (uint8_t)((lThursday - daysFromCivil(lYear, 1, 1)) / 7 + 1);
+    }
+
+    // easter sunday as days after march 22nd (Gauss)
+    constexpr uint8_t easterOffset(int16_t iYear)
+    {
+        uint8_t a = iYear % 19;
+        uint8_t b = iYear % 4;
+        uint8_t c = iYear % 7;
+
+        uint8_t k = iYear / 100;
+        uint8_t q = k / 4;
+        uint8_t p = ((8 * k) + 13) / 25;
+        uint8_t Egz = (38 - (k - q) + p) % 30; // Die Jahrhundertepakte
+        uint8_t M = (53 - Egz) % 30;
+        uint8_t N = (4 + k - q) % 7;
+
+        uint8_t d = ((19 * a) + M) % 30;
+        uint8_t e = ((2 * b) + (4 * c) + (6 * d) + N) % 7;
+
+        // Zwei Ausnahmen berücksichtigen (26. und 25. April):
+        if (d + e == 35)
+            return 28;
+        if (d + e == 34 && d == 28 && a > 10)
+            return 27;
+        return d + e;
+    }
+
+    // day in december of the fourth advent
+    constexpr uint8_t adventDay(int16_t iYear)
+    {
+        return 24 - weekday(daysFromCivil(iYear, 12, 24));
+    }
+} // namespace TimerCalendar
@@ -3,49 +3,119 @@
 #include <ctime>
 #include "OpenKNX.h"
 
-sDay TimerModule::cHolidays[cHolidaysCount] = {
-    {1, 1},
-    {6, 1},
-    {-52, EASTER},
-    {-48, EASTER},
-    {-47, EASTER},
-    {-46, EASTER},
-    {8, 3},
-    {-3, EASTER},
-    {-2, EASTER},
-    {0, EASTER},
-    {1, EASTER},
-    {1, 5},
-    {39, EASTER},
-    {49, EASTER},
-    {50, EASTER},
-    {60, EASTER},
-    {8, 8},
-    {15, 8},
-    {3, 10},
-    {31, 10},
-    {1, 11},
-    {-32, ADVENT},
-    {-21, ADVENT},
-    {-14, ADVENT},
-    {-7, ADVENT},
-    {0, ADVENT},
-    {24, 12},
-    {25, 12},
-    {26, 12},
-    {31, 12},
-    {26, 10},
-    {8, 12}
+// holiday rules in flash, the holiday number is the position in this table (1..32)
+static const uint16_t cHolidayRules[TIMER_HOLIDAY_COUNT] = {
+    HOLIDAY_FIXED(1, 1),                 //  1 Neujahr
+    HOLIDAY_FIXED(6, 1),                 //  2 Heilige Drei Könige
+    HOLIDAY_EASTER(-52),                 //  3 Weiberfastnacht
+    HOLIDAY_EASTER(-48),                 //  4 Rosenmontag
+    HOLIDAY_EASTER(-47),                 //  5 Fastnachtsdienstag
+    HOLIDAY_EASTER(-46),                 //  6 Aschermittwoch
+    HOLIDAY_FIXED(8, 3),                 //  7 Frauentag
+    HOLIDAY_EASTER(-3),                  //  8 Gründonnerstag
+    HOLIDAY_EASTER(-2),                  //  9 Karfreitag
+    HOLIDAY_EASTER(0),                   // 10 Ostersonntag
+    HOLIDAY_EASTER(1),                   // 11 Ostermontag
+    HOLIDAY_FIXED(1, 5),                 // 12 Tag der Arbeit
+    HOLIDAY_EASTER(39),                  // 13 Christi Himmelfahrt
+    HOLIDAY_EASTER(49),                  // 14 Pfingstsonntag
+    HOLIDAY_EASTER(50),                  // 15 Pfingstmontag
+    HOLIDAY_EASTER(60),                  // 16 Fronleichnam
+    HOLIDAY_FIXED(8, 8),                 // 17 Augsburger Friedensfest
+    HOLIDAY_FIXED(15, 8),                // 18 Mariä Himmelfahrt
+    HOLIDAY_FIXED(3, 10),                // 19 Tag der Deutschen Einheit
+    HOLIDAY_FIXED(31, 10),               // 20 Reformationstag
+    HOLIDAY_FIXED(1, 11),                // 21 Allerheiligen
+    HOLIDAY_WEEKDAY_BEFORE(3, 23, 11),   // 22 Buß- und Bettag (wednesday before 23.11.)
+    HOLIDAY_ADVENT(-21),                 // 23 1. Advent
+    HOLIDAY_ADVENT(-14),                 // 24 2. Advent
+    HOLIDAY_ADVENT(-7),                  // 25 3. Advent
+    HOLIDAY_ADVENT(0),                   // 26 4. Advent
+    HOLIDAY_FIXED(24, 12),               // 27 Heiligabend
+    HOLIDAY_FIXED(25, 12),               // 28 1. Weihnachtstag
+    HOLIDAY_FIXED(26, 12),               // 29 2. Weihnachtstag
+    HOLIDAY_FIXED(31, 12),               // 30 Silvester
+    HOLIDAY_FIXED(26, 10),               // 31 Nationalfeiertag (AT)
+    HOLIDAY_FIXED(8, 12)                 // 32 Mariä Empfängnis
 };
 
+// bit of a holiday number in a holiday mask, holiday 1 is the most significant bit
+#define HOLIDAY_BIT(id) (0x80000000UL >> ((id)-1))
+#define HOLIDAYS_DE (HOLIDAY_BIT(1) | HOLIDAY_BIT(9) | HOLIDAY_BIT(11) | HOLIDAY_BIT(12) | HOLIDAY_BIT(13) | HOLIDAY_BIT(15) | HOLIDAY_BIT(19) | HOLIDAY_BIT(28) | HOLIDAY_BIT(29))
+
+// public holidays of the regions selectable with setHolidayRegion()
+static const uint32_t cHolidayRegions[TIMER_REGION_COUNT] = {
+    HOLIDAYS_DE,                                                         // TIMER_REGION_DE
+    HOLIDAYS_DE | HOLIDAY_BIT(2) | HOLIDAY_BIT(16) | HOLIDAY_BIT(21),   // TIMER_REGION_DE_BW
+    HOLIDAYS_DE | HOLIDAY_BIT(2) | HOLIDAY_BIT(16) | HOLIDAY_BIT(18) | HOLIDAY_BIT(21), // TIMER_REGION_DE_BY
+    HOLIDAYS_DE | HOLIDAY_BIT(7),                                        // TIMER_REGION_DE_BE
+    HOLIDAYS_DE | HOLIDAY_BIT(10) | HOLIDAY_BIT(14) | HOLIDAY_BIT(20),  // TIMER_REGION_DE_BB
+    HOLIDAYS_DE | HOLIDAY_BIT(20),                                       // TIMER_REGION_DE_HB
+    HOLIDAYS_DE | HOLIDAY_BIT(20),                                       // TIMER_REGION_DE_HH
+    HOLIDAYS_DE | HOLIDAY_BIT(16),                                       // TIMER_REGION_DE_HE
+    HOLIDAYS_DE | HOLIDAY_BIT(7) | HOLIDAY_BIT(20),                     // TIMER_REGION_DE_MV
+    HOLIDAYS_DE | HOLIDAY_BIT(20),                                       // TIMER_REGION_DE_NI
+    HOLIDAYS_DE | HOLIDAY_BIT(16) | HOLIDAY_BIT(21),                    // TIMER_REGION_DE_NW
+    HOLIDAYS_DE | HOLIDAY_BIT(16) | HOLIDAY_BIT(21),                    // TIMER_REGION_DE_RP
+    HOLIDAYS_DE | HOLIDAY_BIT(16) | HOLIDAY_BIT(18) | HOLIDAY_BIT(21),  // TIMER_REGION_DE_SL
+    HOLIDAYS_DE | HOLIDAY_BIT(20) | HOLIDAY_BIT(22),                    // TIMER_REGION_DE_SN
+    HOLIDAYS_DE | HOLIDAY_BIT(2) | HOLIDAY_BIT(20),                     // TIMER_REGION_DE_ST
+    HOLIDAYS_DE | HOLIDAY_BIT(20),                                       // TIMER_REGION_DE_SH
+    HOLIDAYS_DE | HOLIDAY_BIT(20),                                       // TIMER_REGION_DE_TH
+    HOLIDAY_BIT(1) | HOLIDAY_BIT(2) | HOLIDAY_BIT(11) | HOLIDAY_BIT(12) | HOLIDAY_BIT(13) | HOLIDAY_BIT(15) | HOLIDAY_BIT(16) |
+        HOLIDAY_BIT(18) | HOLIDAY_BIT(21) | HOLIDAY_BIT(28) | HOLIDAY_BIT(29) | HOLIDAY_BIT(31) | HOLIDAY_BIT(32) // TIMER_REGION_AT
+};
+
+// Easter and fourth advent for MINYEAR..TIMER_TABLE_MAXYEAR, generated at compile time into flash.
+// Bits 0-5: easter sunday as days after march 22nd, bits 6-8: fourth advent as days after december 18th
+struct sEasterAdventTable
+{
+    uint16_t entry[TIMER_TABLE_MAXYEAR - MINYEAR + 1];
+
+    constexpr sEasterAdventTable() : entry()
+    {
+        for (int16_t lYear = MINYEAR; lYear <= TIMER_TABLE_MAXYEAR; lYear++)
+            entry[lYear - MINYEAR] = TimerCalendar::easterOffset(lYear) | (TimerCalendar::adventDay(lYear) - 18) << 6;
+    }
+};
+static constexpr sEasterAdventTable cEasterAdventTable;
+
+// independent easter algorithm (Meeus/Jones/Butcher) to verify the table
+constexpr uint8_t easterOffsetMeeus(int16_t iYear)
+{
+    int16_t a = iYear % 19, b = iYear / 100, c = iYear % 100;
+    int16_t f = (b + 8) / 25, g = (b - f + 1) / 3;
+    int16_t h = (19 * a + b - b / 4 - g + 15) % 30;
+    int16_t l = (32 + 2 * (b % 4) + 2 * (c / 4) - h - c % 4) % 7;
+    int16_t m = (a + 11 * h + 22 * l) / 451;
+    int16_t lMonth = (h + l - 7 * m + 114) / 31;
+    int16_t lDay = (h + l - 7 * m + 114) % 31 + 1;
+    return (lMonth == 3) ? lDay - 22 : lDay + 9;
+}
+
+constexpr bool checkEasterAdventTable()
+{
+    for (int16_t lYear = MINYEAR; lYear <= TIMER_TABLE_MAXYEAR; lYear++)
+    {
+        uint16_t lEntry = cEasterAdventTable.entry[lYear - MINYEAR];
+        if ((lEntry & 0x3F) != easterOffsetMeeus(lYear))
+            return false;
+        if (TimerCalendar::weekday(TimerCalendar::daysFromCivil(lYear, 3, 22 + (lEntry & 0x3F))) != 0)
+            return false;
+        if (TimerCalendar::weekday(TimerCalendar::daysFromCivil(lYear, 12, 18 + (lEntry >> 6))) != 0)
+            return false;
+    }
+    return true;
+}
+static_assert(checkEasterAdventTable(), "easter/advent table does not match the reference algorithm");
+static_assert(cEasterAdventTable.entry[2024 - MINYEAR] == (9 | (22 - 18) << 6), "easter 2024 is 31.03., fourth advent 22.12.");
+
 TimerModule::TimerModule()
 {
-    mNow.tm_year = 120;
-    mNow.tm_mon = 0;
-    mNow.tm_mday = 1;
-    mNow.tm_wday = 3;
-    mktime(&mNow);
-    mTimeDelay = millis();
+    setEpoch(TimerCalendar::daysFromCivil(2020, 1, 1) * 86400UL);
+    addTimeSource(TIMER_PRIORITY_BUS, 2);
+    mRecalc.holidays.year = -1;
+    mTimeDelay = TIMER_MILLIS();
 }
 
 TimerModule::~TimerModule()
@@ -67,73 +137,204 @@ const std::string TimerModule::version()
 
 void TimerModule::setup()
 {
-    uint32_t iHolidayBitmask = 0x0000;
     mLongitude = ParamBASE_Longitude;
     mLatitude = ParamBASE_Latitude;
-    mTimezone = ParamBASE_Timezone;
-    mUseSummertime = (ParamBASE_SummertimeAll == VAL_STIM_FROM_INTERN);
-    mTimezone = ParamBASE_Timezone;
-    // we delete all unnecessary holidays from holiday data
-    for (uint8_t i = 0; i < cHolidaysCount; i++)
+    // a rule set by setTimezone() is more detailed than the parameter
+    if (!mTimezoneSet)
     {
-        if ((iHolidayBitmask & 0x80000000) == 0)
-            cHolidays[i].month = REMOVED;
-        iHolidayBitmask <<= 1;
+        mTimezone = ParamBASE_Timezone;
+        mTimezoneRule.offset = mTimezone * 60;
+        mDstYear = -1;
     }
+    mUseSummertime = (ParamBASE_SummertimeAll == VAL_STIM_FROM_INTERN);
+    mEventsDirty = true;
+    // the holiday mask keeps its default (no holidays) or the region set by setHolidayRegion()/setHolidayMask()
 }
 
 void TimerModule::loop()
 {
-    if (delayCheck(mTimeDelay, 1000))
+    TIMER_STAT(TIMER_STAT_LOOP);
+    if (TIMER_MILLIS() - mSourcePollTime >= TIMER_SOURCE_POLL)
+        pollTimeSources();
+    // a date or time telegram waited in vain for its counterpart
+    if (mBusPending.parts && TIMER_MILLIS() - mBusPending.received >= TIMER_COALESCE_WINDOW)
+        flushBusTime();
+    int32_t lElapsed = (int32_t)(TIMER_MILLIS() - mTimeDelay);
+    if (lElapsed >= 1000)
     {
-        mTimeDelay += 1000;
-        mNow.tm_sec += 1;
-        mktime(&mNow);
-        if (mTimeValid == tmValid)
+        uint32_t lSeconds = lElapsed / 1000;
+        adjustTimeDelay(lSeconds);
+        if (lSeconds > 1)
         {
-            // prevent that a minute is missed, if an other hour is set with the same minute
-            if (mHourTick != mNow.tm_hour)
-            {
-                mHourTick = mNow.tm_hour;
-                mMinuteTick = -1;
-            }
-            if (mMinuteTick != mNow.tm_min)
-            {
-                mMinuteChanged = true;
-                // just call once a minute
-                mMinuteTick = mNow.tm_min;
-                if (mUseSummertime && (getMonth() == 3 || getMonth() == 10) && getHour() == 3 && getMinute() == 1)
-                    calculateSummertime();
-            }
-            // Ensure that a changed month causes a recalculation of all static dates/times
-            if (mMonthTick != mNow.tm_mon)
-            {
-                mMonthTick = mNow.tm_mon;
-                mYearTick = -1;
-                mDayTick = -1;
-            }
-            if (mYearTick != mNow.tm_year)
-            {
-                calculateEaster();
-                calculateAdvent();
-                calculateSummertime(); // initial summertime calculation if year changes
-                calculateHolidays();
-                mYearTick = mNow.tm_year;
-            }
-            // important: Day calculations AFTER year calculations
-            if (mDayTick != mNow.tm_mday)
+            // loop was starved, i.e. by a blocking flash write
+            mLagCount++;
+            if (lSeconds - 1 > mLagMax)
+                mLagMax = lSeconds - 1;
+        }
+        // missed minutes are replayed one by one (up to TIMER_CATCHUP_REPLAY), older ones are coalesced
+        uint32_t lSkip = (lSeconds > TIMER_CATCHUP_REPLAY * 60UL) ? lSeconds - TIMER_CATCHUP_REPLAY * 60UL : 0;
+        while (lSeconds > 0)
+        {
+            uint32_t lStep = 60 - mNow.second;
+            if (lStep < lSkip)
+                lStep = lSkip;
+            if (lStep > lSeconds)
+                lStep = lSeconds;
+            lSkip = 0;
+            lSeconds -= lStep;
+            advanceSeconds(lStep);
+            if (isClockRunning())
+                processTick();
+            if (lSeconds > 0 && mPendingChanges)
             {
-                calculateSunriseSunset();
-                if (!mHolidayChanged)
-                    calculateHolidays();
-                mDayTick = mNow.tm_mday;
+                updateSnapshot();
+                notifyListeners();
             }
         }
     }
+#ifdef TIMER_SUN_TABLE
+    else if (isClockRunning() && mRecalc.step == TIMER_RECALC_IDLE)
+    {
+        // use idle loops to fill up the sun table
+        processSunTable();
+    }
+#endif
+    if (mRecalc.step != TIMER_RECALC_IDLE)
+    {
+        processRecalc(TIMER_RECALC_BUDGET);
+#if TIMER_MAX_RULES > 0
+        // rules of a new day are compiled as soon as its holidays and sun times are published
+        if (isClockRunning())
+            processRules();
+#endif
+    }
+    updateSnapshot();
+    if (mPendingChanges)
+        notifyListeners();
+}
+
+// date and time dependant calculations, called after each advance of the clock
+void TimerModule::processTick()
+{
+    // prevent that a minute is missed, if an other hour is set with the same minute
+    if (mHourTick != mNow.hour)
+    {
+        mHourTick = mNow.hour;
+        mMinuteTick = -1;
+        mPendingChanges |= TIMER_CHANGE_HOUR;
+    }
+    if (mMinuteTick != mNow.minute)
+    {
+        mMinuteChanged = true;
+        mPendingChanges |= TIMER_CHANGE_MINUTE;
+        // just call once a minute
+        mMinuteTick = mNow.minute;
+        calculateSummertime();
+    }
+    // Ensure that a changed month causes a recalculation of all static dates/times
+    if (mMonthTick != mNow.month)
+    {
+        mMonthTick = mNow.month;
+        mYearTick = -1;
+        mDayTick = -1;
+    }
+    if (mYearTick != mNow.year)
+    {
+        calculateSummertime(); // initial summertime calculation if year changes
+        mYearTick = mNow.year;
+    }
+    // holidays and sun are recalculated by processRecalc(), which signals the day change when done
+    if (mDayTick != mNow.day)
+    {
+        startRecalc(true);
+        mDayTick = mNow.day;
+    }
+    processEvents();
+#if TIMER_MAX_RULES > 0
+    processRules();
+#endif
+}
+
+// moves mTimeDelay by the given seconds, corrected by the learned drift and the offset to be slewed
+void TimerModule::adjustTimeDelay(uint32_t iSeconds)
+{
+    int64_t lAccu = mDriftAccu + (int64_t)mDriftPpb * iSeconds;
+    int32_t lAdjust = (int32_t)(lAccu / 1000000);
+    mDriftAccu = (int32_t)(lAccu - lAdjust * 1000000LL);
+    if (mSlewRemaining != 0)
+    {
+        int32_t lMax = (iSeconds > 0x7FFFFFFFUL / TIMER_SLEW_RATE) ? 0x7FFFFFFFL : TIMER_SLEW_RATE * (int32_t)iSeconds;
+        int32_t lSlew = (mSlewRemaining > lMax) ? lMax : (mSlewRemaining < -lMax) ? -lMax : mSlewRemaining;
+        mSlewRemaining -= lSlew;
+        lAdjust -= lSlew;
+    }
+    mTimeDelay += iSeconds * 1000 + lAdjust;
+}
+
+// advances mNow by the given seconds in constant time
+void TimerModule::advanceSeconds(uint32_t iSeconds)
+{
+    if (iSeconds == 1)
+    {
+        tickSecond();
+        return;
+    }
+    // a skipped hour or minute might end up with the same value
+    if (iSeconds >= 3600)
+        mHourTick = -1;
+    if (iSeconds >= 60)
+        mMinuteTick = -1;
+    uint32_t lEpoch = mEpoch + iSeconds;
+    if (lEpoch / 86400 != (uint32_t)mDayNumber)
+        setDate(lEpoch / 86400);
+    setEpoch(lEpoch);
+}
+
+// advances mNow by one second, fields are just carried on rollover
+void TimerModule::tickSecond()
+{
+    mEpoch++;
+    if (++mNow.second < 60)
+        return;
+    mNow.second = 0;
+    if (++mNow.minute < 60)
+        return;
+    mNow.minute = 0;
+    if (++mNow.hour < 24)
+        return;
+    mNow.hour = 0;
+    mDayNumber++;
+    mNow.weekday = (mNow.weekday == 6) ? 0 : mNow.weekday + 1;
+    mNow.yearDay++;
+    if (++mNow.day <= TimerCalendar::daysInMonth(mNow.year, mNow.month))
+        return;
+    mNow.day = 1;
+    if (++mNow.month <= 12)
+        return;
+    mNow.month = 1;
+    mNow.yearDay = 0;
+    mNow.year++;
+}
+
+// sets the clock to the given local seconds since 1970 and recalculates the cached fields
+void TimerModule::setEpoch(uint32_t iEpoch)
+{
+    int16_t lYear;
+    mEpoch = iEpoch;
+    mDayNumber = iEpoch / 86400;
+    uint32_t lSecond = iEpoch % 86400;
+    mNow.hour = lSecond / 3600;
+    mNow.minute = (lSecond / 60) % 60;
+    mNow.second = lSecond % 60;
+    TimerCalendar::civilFromDays(mDayNumber, lYear, mNow.month, mNow.day);
+    mNow.year = lYear;
+    mNow.weekday = TimerCalendar::weekday(mDayNumber);
+    mNow.yearDay = TimerCalendar::dayOfYear(lYear, mNow.month, mNow.day);
 }
 
 void TimerModule::processInputKo(GroupObject &ko)
 {
+    TIMER_STAT(TIMER_STAT_INPUT);
     uint16_t koNum = ko.asap();
 
     #ifdef BASE_Share_KoOffset
@@ -147,47 +348,30 @@ void TimerModule::processInputKo(GroupObject &ko)
     {
         case BASE_KoTime:
         {
+            int32_t lDayNumber, lSecond;
             if(ParamBASE_CombinedTimeDate)
             {
-                KNXValue value = "";
-
-                // first ensure we have a valid data-time content
-                // (including the correct length)
-                if (ko.tryValue(value, Dpt(19,1)))
+                uint8_t *raw = ko.valueRef();
+                if (decodeBusTime(raw, ko.valueSize(), TIMER_BUS_DATE | TIMER_BUS_TIME, &lDayNumber, &lSecond))
                 {
-                    uint8_t *raw = ko.valueRef();
-
-                    if (!(raw[6] & (DPT19_FAULT | DPT19_NO_YEAR | DPT19_NO_DATE | DPT19_NO_TIME)))
-                    {
-                        struct tm lTmp = value;
-                        setDateTimeFromBus(&lTmp);
-                        const bool lSummertime = raw[6] & DPT19_SUMMERTIME;
-                        // TODO check using ParamLOG_SummertimeAll
-                        if (ParamBASE_SummertimeAll == VAL_STIM_FROM_DPT19)
-                            setIsSummertime(lSummertime);
-                    }
+                    receiveBusTime(TIMER_BUS_DATE | TIMER_BUS_TIME, lDayNumber, lSecond);
+                    const bool lSummertime = raw[6] & DPT19_SUMMERTIME;
+                    // TODO check using ParamLOG_SummertimeAll
+                    if (ParamBASE_SummertimeAll == VAL_STIM_FROM_DPT19)
+                        setIsSummertime(lSummertime);
                 }
             } else {
-                KNXValue value = "";
-                // ensure we have a valid time content
-                if (ko.tryValue(value, Dpt(10, 1, 1)))
-                { 
-                    struct tm lTmp = value;
-                    setTimeFromBus(&lTmp);
-                }
+                if (decodeBusTime(ko.valueRef(), ko.valueSize(), TIMER_BUS_TIME, &lDayNumber, &lSecond))
+                    receiveBusTime(TIMER_BUS_TIME, 0, lSecond);
             }
             break;
         }
 
         case BASE_KoDate:
         {
-            KNXValue value = "";
-            // ensure we have a valid date content
-            if (ko.tryValue(value, Dpt(11, 1)))
-            {
-                struct tm lTmp = value;
-                setDateFromBus(&lTmp);
-            }
+            int32_t lDayNumber, lSecond;
+            if (decodeBusTime(ko.valueRef(), ko.valueSize(), TIMER_BUS_DATE, &lDayNumber, &lSecond))
+                receiveBusTime(TIMER_BUS_DATE, lDayNumber, 0);
             break;
         }
 
@@ -199,283 +383,1450 @@ void TimerModule::processInputKo(GroupObject &ko)
     }
 }
 
-void TimerModule::convertToLocalTime(double iTime, sTime *eTime)
+// converts UT minutes of day to local minutes of day
+int16_t TimerModule::toLocalMinutes(int16_t iMinutes)
+{
+    return iMinutes + getUtcOffset();
+}
+
+// converts UT minutes of day to local minutes of day for an other day, summertime is taken from the rules
+int16_t TimerModule::toLocalMinutes(int16_t iMinutes, int32_t iDayNumber)
+{
+    return iMinutes + getUtcOffset(iDayNumber, iMinutes);
+}
+
+// local minutes to time of day, times beyond midnight (i.e. polar day) are wrapped into the day
+static void minutesToTime(int16_t iMinutes, sTime *eTime)
+{
+    iMinutes %= 1440;
+    if (iMinutes < 0)
+        iMinutes += 1440;
+    eTime->minute = iMinutes % 60;
+    eTime->hour = iMinutes / 60;
+}
+
+// converts UT minutes of day to local time
+void TimerModule::convertToLocalTime(int16_t iMinutes, sTime *eTime)
+{
+    minutesToTime(toLocalMinutes(iMinutes), eTime);
+}
+
+// converts UT minutes of day to local time for an other day, summertime is taken from the rules
+void TimerModule::convertToLocalTime(int16_t iMinutes, int32_t iDayNumber, sTime *eTime)
 {
-    eTime->hour = (int)floor(iTime);
-    eTime->minute = (int)(60 * (iTime - floor(iTime)));
-    eTime->hour += mTimezone + ((mIsSummertime) ? 1 : 0);
+    minutesToTime(toLocalMinutes(iMinutes, iDayNumber), eTime);
+}
+
+// sunrise/sunset of the given day in UT minutes of day, for dates of the current year
+// this is just a table lookup if TIMER_SUN_TABLE is defined
+void TimerModule::calculateSunriseSunset(int16_t iYear, uint8_t iMonth, uint8_t iDay, int16_t *eRise, int16_t *eSet)
+{
+#ifdef TIMER_SUN_TABLE
+    uint16_t lDayOfYear = TimerCalendar::dayOfYear(iYear, iMonth, iDay);
+    if (mSunTableYear == iYear && lDayOfYear < mSunTableCount && mSunTableLongitude == mLongitude && mSunTableLatitude == mLatitude)
+    {
+        *eRise = mSunTable[lDayOfYear][SUN_SUNRISE];
+        *eSet = mSunTable[lDayOfYear][SUN_SUNSET];
+        return;
+    }
+#endif
+    sunRiseSet(iYear, iMonth, iDay, mLongitude, mLatitude, -35.0f / 60.0f, 1, eRise, eSet);
 }
 
 void TimerModule::calculateSunriseSunset()
 {
-    double rise, set;
-    // sunrise/sunset calculation
-    sunRiseSet(getYear(), getMonth(), getDay(),
-               mLongitude, mLatitude, -35.0 / 60.0, 1, &rise, &set);
-    convertToLocalTime(rise, &mSunrise);
-    convertToLocalTime(set, &mSunset);
+    int16_t lRise, lSet;
+    calculateSunriseSunset(getYear(), getMonth(), getDay(), &lRise, &lSet);
+    convertToLocalTime(lRise, &mSunrise);
+    convertToLocalTime(lSet, &mSunset);
+}
+
+#ifdef TIMER_SUN_TABLE
+// calculates the next missing day of the sun table, restarts on year or location change
+void TimerModule::processSunTable()
+{
+    if (mSunTableYear != getYear() || mSunTableLongitude != mLongitude || mSunTableLatitude != mLatitude)
+    {
+        mSunTableYear = getYear();
+        mSunTableLongitude = mLongitude;
+        mSunTableLatitude = mLatitude;
+        mSunTableCount = 0;
+    }
+    if (mSunTableCount >= TimerCalendar::daysInYear(mSunTableYear))
+        return;
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(TimerCalendar::daysFromCivil(mSunTableYear, 1, 1) + mSunTableCount, lYear, lMonth, lDay);
+    sunRiseSet(lYear, lMonth, lDay, mLongitude, mLatitude, -35.0f / 60.0f, 1, &mSunTable[mSunTableCount][SUN_SUNRISE], &mSunTable[mSunTableCount][SUN_SUNSET]);
+    mSunTableCount++;
 }
+#endif
 
 void TimerModule::setTimeFromBus(tm *iTime)
 {
-    if (mNow.tm_min != iTime->tm_min || mNow.tm_hour != iTime->tm_hour)
-        mMinuteChanged = true;
-    mNow.tm_sec = iTime->tm_sec;
-    mNow.tm_min = iTime->tm_min;
-    mNow.tm_hour = iTime->tm_hour;
-    mktime(&mNow);
-    mTimeDelay = millis();
-    mTimeValid = static_cast<eTimeValid>(mTimeValid | tmMinutesValid);
+    if (iTime->tm_hour > 23 || iTime->tm_min > 59 || iTime->tm_sec > 59)
+        return;
+    acceptTime(TIMER_SOURCE_BUS, TIMER_BUS_TIME, 0, iTime->tm_hour * 3600L + iTime->tm_min * 60 + iTime->tm_sec, TIMER_MILLIS());
 }
 
 void TimerModule::setDateFromBus(tm *iDate)
 {
+    if (iDate->tm_mon < 1 || iDate->tm_mon > 12 || iDate->tm_mday < 1 || iDate->tm_mday > TimerCalendar::daysInMonth(iDate->tm_year, iDate->tm_mon))
+        return;
+    acceptTime(TIMER_SOURCE_BUS, TIMER_BUS_DATE, TimerCalendar::daysFromCivil(iDate->tm_year, iDate->tm_mon, iDate->tm_mday), 0, TIMER_MILLIS());
+}
+
+// decodes DPT10, DPT11 and DPT19 directly from the group object data, returns the decoded parts
+uint8_t TimerModule::decodeBusTime(uint8_t *iData, uint8_t iSize, uint8_t iParts, int32_t *eDayNumber, int32_t *eSecond)
+{
+    uint8_t lHour = 0, lMinute = 0, lSecond = 0, lDay = 0, lMonth = 0;
+    int16_t lYear = 0;
+    if (iParts == (TIMER_BUS_DATE | TIMER_BUS_TIME))
+    {
+        // DPT19: year, month, day, weekday/hour, minute, second, flags, clock quality
+        if (iSize != 8 || (iData[6] & (DPT19_FAULT | DPT19_NO_YEAR | DPT19_NO_DATE | DPT19_NO_TIME)))
+            return 0;
+        lYear = 1900 + iData[0];
+        lMonth = iData[1] & 0x0F;
+        lDay = iData[2] & 0x1F;
+        lHour = iData[3] & 0x1F;
+        lMinute = iData[4] & 0x3F;
+        lSecond = iData[5] & 0x3F;
+    }
+    else if (iParts == TIMER_BUS_TIME)
+    {
+        // DPT10: weekday/hour, minute, second
+        if (iSize != 3)
+            return 0;
+        lHour = iData[0] & 0x1F;
+        lMinute = iData[1] & 0x3F;
+        lSecond = iData[2] & 0x3F;
+    }
+    else
+    {
+        // DPT11: day, month, year (< 90 is 20xx)
+        if (iSize != 3)
+            return 0;
+        lDay = iData[0] & 0x1F;
+        lMonth = iData[1] & 0x0F;
+        lYear = iData[2] & 0x7F;
+        lYear += (lYear < 90) ? 2000 : 1900;
+    }
+    if (iParts & TIMER_BUS_TIME)
+    {
+        if (lHour > 23 || lMinute > 59 || lSecond > 59)
+            return 0;
+        *eSecond = lHour * 3600L + lMinute * 60 + lSecond;
+    }
+    if (iParts & TIMER_BUS_DATE)
+    {
+        if (lMonth < 1 || lMonth > 12 || lDay < 1 || lDay > TimerCalendar::daysInMonth(lYear, lMonth))
+            return 0;
+        *eDayNumber = TimerCalendar::daysFromCivil(lYear, lMonth, lDay);
+    }
+    return iParts;
+}
+
+// collects date and time telegrams arriving within TIMER_COALESCE_WINDOW to one update
+void TimerModule::receiveBusTime(uint8_t iParts, int32_t iDayNumber, int32_t iSecond)
+{
+    uint32_t lMillis = TIMER_MILLIS();
+    // a part, which is already pending, belongs to an other update
+    if (mBusPending.parts & iParts)
+        flushBusTime();
+    if (!mBusPending.parts)
+        mBusPending.received = lMillis;
+    if (iParts & TIMER_BUS_DATE)
+        mBusPending.dayNumber = iDayNumber;
+    if (iParts & TIMER_BUS_TIME)
+    {
+        mBusPending.second = iSecond;
+        mBusPending.timeMillis = lMillis;
+    }
+    mBusPending.parts |= iParts;
+    if (mBusPending.parts == (TIMER_BUS_DATE | TIMER_BUS_TIME))
+        flushBusTime();
+}
+
+void TimerModule::flushBusTime()
+{
+    uint8_t lParts = mBusPending.parts;
+    mBusPending.parts = 0;
+    if (lParts)
+        acceptTime(TIMER_SOURCE_BUS, lParts, mBusPending.dayNumber, mBusPending.second, mBusPending.timeMillis);
+}
+
+// day of a time without date, a time just on the other side of midnight belongs to the other day
+int32_t TimerModule::resolveBusDay(uint8_t iParts, int32_t iDayNumber, int32_t iSecond)
+{
+    if (iParts & TIMER_BUS_DATE)
+        return iDayNumber;
+    int32_t lDiff = iSecond - (int32_t)(mEpoch % 86400);
+    if ((mTimeValid & tmDateValid) && (mTimeValid & tmMinutesValid))
+        return mDayNumber + ((lDiff > 86400 - TIMER_MIDNIGHT_WINDOW) ? -1 : (lDiff < TIMER_MIDNIGHT_WINDOW - 86400) ? 1 : 0);
+    return mDayNumber;
+}
+
+// offset in ms of the given time received at iMillis to the clock (positive = clock is behind)
+int64_t TimerModule::offsetTo(int32_t iDayNumber, int32_t iSecond, uint32_t iMillis)
+{
+    return (int64_t)(iDayNumber - mDayNumber) * 86400000LL + (iSecond - (int32_t)(mEpoch % 86400)) * 1000LL - (int32_t)(iMillis - mTimeDelay);
+}
+
+// applies date and/or time from the bus as one update, iMillis is the reception time of the time
+void TimerModule::applyBusTime(uint8_t iParts, int32_t iDayNumber, int32_t iSecond, uint32_t iMillis)
+{
+    TIMER_COUNT(TIMER_COUNT_SYNC);
+    int32_t lSecondOfDay = getHour() * 3600L + getMinute() * 60 + getSecond();
+    if (!(iParts & TIMER_BUS_TIME))
+    {
+        if ((mTimeValid & tmMinutesValid) && iDayNumber != mDayNumber)
+        {
+            // a slewed clock might be a few seconds apart from midnight of the bus,
+            // in this case the date belongs to the other side of midnight
+            if (iDayNumber == mDayNumber + 1 && lSecondOfDay >= 86400 - TIMER_MIDNIGHT_WINDOW)
+            {
+                setEpoch(mDayNumber * 86400UL);
+                mTimeDelay = TIMER_MILLIS();
+                mSlewRemaining = 0;
+            }
+            else if (iDayNumber == mDayNumber - 1 && lSecondOfDay < TIMER_MIDNIGHT_WINDOW)
+            {
+                setEpoch(mDayNumber * 86400UL + 86399);
+                mTimeDelay = TIMER_MILLIS();
+                mSlewRemaining = 0;
+            }
+        }
+    }
+    else
+    {
+        bool lHasDate = (iParts & TIMER_BUS_DATE) || (mTimeValid & tmDateValid);
+        iDayNumber = resolveBusDay(iParts, iDayNumber, iSecond);
+        bool lSlew = false;
+        if (mTimeValid & tmMinutesValid)
+        {
+            int64_t lOffset = offsetTo(iDayNumber, iSecond, iMillis);
+            mClockOffset = (lOffset > INT32_MAX) ? INT32_MAX : (lOffset < INT32_MIN) ? INT32_MIN : (int32_t)lOffset;
+            if (lHasDate)
+                learnDrift((int64_t)iDayNumber * 86400000LL + iSecond * 1000LL, iMillis);
+            // small offsets are slewed, the clock is not stepped, even across midnight
+            lSlew = (lOffset > -TIMER_STEP_LIMIT && lOffset < TIMER_STEP_LIMIT);
+            // tiny offsets are left to the drift correction, so different time masters do not steer the clock back and forth
+            if (lSlew && (lOffset >= TIMER_SLEW_DEADBAND || lOffset <= -TIMER_SLEW_DEADBAND))
+            {
+                TIMER_COUNT(TIMER_COUNT_SLEW);
+                mSlewRemaining = mClockOffset;
+            }
+        }
+        if (!lSlew)
+        {
+            TIMER_COUNT(TIMER_COUNT_STEP);
+            if (lSecondOfDay / 60 != iSecond / 60)
+                mMinuteChanged = true;
+            setEpoch(mDayNumber * 86400UL + iSecond);
+            mEventsDirty = true;
+            mDstMinute = 0;
+            mTimeDelay = iMillis;
+            mSlewRemaining = 0;
+        }
+        else
+            iDayNumber = mDayNumber;
+        mTimeValid = static_cast<eTimeValid>(mTimeValid | tmMinutesValid);
+        mTimeProvisional = false;
+    }
+    if (iDayNumber != mDayNumber)
+    {
+        mEventsDirty = true;
+        mDstMinute = 0;
+        setDate(iDayNumber);
+    }
+    if ((iParts & TIMER_BUS_DATE) && getYear() >= MINYEAR)
+        mTimeValid = static_cast<eTimeValid>(mTimeValid | tmDateValid);
+    mSnapshotDirty = true;
+}
+
+// sets the date of the clock, triggers all date dependant calculations if the date changes
+void TimerModule::setDate(int32_t iDayNumber)
+{
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(iDayNumber, lYear, lMonth, lDay);
     // we have to check, if some date dependant calculations have to be done
     // in case of date changes
-    if (iDate->tm_year != getYear())
+    if (lYear != getYear())
     {
         mYearTick = -1; // triggers easter calculation
         mDayTick = -1;  // triggers sunrise/sunset calculation
         mMinuteChanged = true;
     }
-    else if (iDate->tm_mon != getMonth() || iDate->tm_mday != getDay())
+    else if (lMonth != getMonth() || lDay != getDay())
     {
         mDayTick = -1; // triggers sunrise/sunset calculation
         mMinuteChanged = true;
     }
-    mNow.tm_mday = iDate->tm_mday;
-    mNow.tm_mon = iDate->tm_mon - 1;
-    mNow.tm_year = iDate->tm_year - 1900;
-    mktime(&mNow);
-    mTimeDelay = millis();
-    if (mNow.tm_year >= MINYEAR-1900)
-        mTimeValid = static_cast<eTimeValid>(mTimeValid | tmDateValid);
+    setEpoch(iDayNumber * 86400UL + mEpoch % 86400);
 }
 
-void TimerModule::setDateTimeFromBus(tm *iDateTime)
+int8_t TimerModule::addTimeSource(uint8_t iPriority, uint8_t iStratum, TimerSourceCallback iPoll, void *iContext)
 {
-    // TODO DPT19: check optimizations
-    setTimeFromBus(iDateTime);
-    setDateFromBus(iDateTime);
+    for (uint8_t i = 0; i < TIMER_MAX_SOURCES; i++)
+    {
+        if (mSources[i].used)
+            continue;
+        mSources[i] = {};
+        mSources[i].used = true;
+        mSources[i].priority = iPriority;
+        mSources[i].stratum = iStratum;
+        mSources[i].poll = iPoll;
+        mSources[i].context = iContext;
+        return i;
+    }
+    return -1;
 }
 
-bool TimerModule::minuteChanged()
+void TimerModule::removeTimeSource(uint8_t iSourceId)
 {
-    return mMinuteChanged && mTimeValid == tmValid;
+    if (iSourceId == TIMER_SOURCE_BUS || iSourceId >= TIMER_MAX_SOURCES)
+        return;
+    mSources[iSourceId].used = false;
+    if (mMasterSource == iSourceId)
+        mMasterSource = -1;
 }
 
-void TimerModule::clearMinuteChanged()
+// time of a source in UTC seconds since 1970, received at iMillis
+bool TimerModule::submitTime(uint8_t iSourceId, uint32_t iUtcEpoch, uint32_t iMillis)
 {
-    mMinuteChanged = false;
+    if (iSourceId >= TIMER_MAX_SOURCES || !mSources[iSourceId].used)
+        return false;
+    int32_t lDayNumber = iUtcEpoch / 86400;
+    uint32_t lLocal = iUtcEpoch + getUtcOffset(lDayNumber, (iUtcEpoch % 86400) / 60) * 60L;
+    return acceptTime(iSourceId, TIMER_BUS_DATE | TIMER_BUS_TIME, lLocal / 86400, lLocal % 86400, iMillis);
 }
 
-uint16_t TimerModule::getYear()
+// the source with the lowest priority value (then stratum) steers the clock as long as it delivers time.
+// Jumps beyond TIMER_OUTLIER_LIMIT have to be confirmed by the next time of the same source.
+bool TimerModule::acceptTime(uint8_t iSourceId, uint8_t iParts, int32_t iDayNumber, int32_t iSecond, uint32_t iMillis)
 {
-    return mNow.tm_year + 1900;
+    sTimerSource &lSource = mSources[iSourceId];
+    if (mMasterSource != iSourceId)
+    {
+        if (mMasterSource >= 0)
+        {
+            sTimerSource &lMaster = mSources[mMasterSource];
+            bool lAlive = (iMillis - lMaster.lastUpdate < TIMER_SOURCE_TIMEOUT);
+            bool lBetter = (lSource.priority < lMaster.priority) || (lSource.priority == lMaster.priority && lSource.stratum < lMaster.stratum);
+            if (lAlive && !lBetter)
+            {
+                lSource.lastUpdate = iMillis;
+                return false;
+            }
+        }
+        mMasterSource = iSourceId;
+        mSourceSwitches++;
+    }
+    lSource.lastUpdate = iMillis;
+    if ((iParts & TIMER_BUS_TIME) && mTimeValid == tmValid && !mTimeProvisional)
+    {
+        int64_t lOffset = offsetTo(resolveBusDay(iParts, iDayNumber, iSecond), iSecond, iMillis);
+        if ((lOffset > TIMER_OUTLIER_LIMIT || lOffset < -TIMER_OUTLIER_LIMIT) && !isSummertimeJump(lOffset))
+        {
+            int64_t lDiff = lOffset - lSource.jumpOffset;
+            if (!lSource.jumpPending || lDiff > TIMER_STEP_LIMIT || lDiff < -TIMER_STEP_LIMIT)
+            {
+                lSource.jumpPending = true;
+                lSource.jumpOffset = lOffset;
+                mSourceRejects++;
+                return false;
+            }
+        }
+        lSource.jumpPending = false;
+    }
+    applyBusTime(iParts, iDayNumber, iSecond, iMillis);
+    return true;
 }
 
-uint8_t TimerModule::getMonth()
+// a jump by the summertime offset close to a transition is the summertime switch of the source, no outlier
+bool TimerModule::isSummertimeJump(int64_t iOffset)
 {
-    return mNow.tm_mon + 1;
+    int64_t lDst = mTimezoneRule.dstOffset * 60000LL;
+    if (lDst == 0)
+        return false;
+    int64_t lDiff = (iOffset > 0) ? iOffset - lDst : iOffset + lDst;
+    if (lDiff > TIMER_OUTLIER_LIMIT || lDiff < -TIMER_OUTLIER_LIMIT)
+        return false;
+    uint32_t lStart, lEnd;
+    calculateDstTransitions(getYear(), &lStart, &lEnd);
+    uint32_t lNow = mDayNumber * 1440 + getHour() * 60 + getMinute();
+    uint32_t lWindow = mTimezoneRule.dstOffset + TIMER_OUTLIER_LIMIT / 60000 + 1;
+    // the clock moves forward at the begin and backward at the end of summertime
+    if (iOffset > 0)
+        return lNow + lWindow >= lStart && lNow <= lStart + lWindow;
+    return lNow + lWindow >= lEnd && lNow <= lEnd + lWindow;
 }
 
-uint8_t TimerModule::getDay()
+// asks all polled time sources
+void TimerModule::pollTimeSources()
 {
-    return mNow.tm_mday;
+    mSourcePollTime = TIMER_MILLIS();
+    for (uint8_t i = 0; i < TIMER_MAX_SOURCES; i++)
+    {
+        uint32_t lEpoch;
+        if (mSources[i].used && mSources[i].poll && mSources[i].poll(&lEpoch, mSources[i].context))
+            submitTime(i, lEpoch, TIMER_MILLIS());
+    }
 }
 
-uint8_t TimerModule::getHour()
+int8_t TimerModule::getTimeSource()
 {
-    return mNow.tm_hour;
+    return mMasterSource;
 }
 
-uint8_t TimerModule::getMinute()
+uint32_t TimerModule::getTimeSourceRejects()
 {
-    return mNow.tm_min;
+    return mSourceRejects;
 }
 
-uint8_t TimerModule::getSecond()
+uint32_t TimerModule::getTimeSourceSwitches()
 {
-    return mNow.tm_sec;
+    return mSourceSwitches;
 }
 
-uint8_t TimerModule::getWeekday()
+// estimates the drift of millis() against the bus time from the first and the latest time telegram
+void TimerModule::learnDrift(int64_t iBusTime, uint32_t iMillis)
 {
-    return mNow.tm_wday;
+    if (mDriftAnchorTime >= 0)
+    {
+        int64_t lReal = iBusTime - mDriftAnchorTime;
+        int64_t lLocal = (uint32_t)(iMillis - mDriftAnchorMillis);
+        int64_t lError = lLocal - lReal;
+        if (lError < 0)
+            lError = -lError;
+        // bus time jumped (i.e. was set manually) or millis() is close to wrap around, start a new measurement
+        if (lReal > 0 && lLocal < TIMER_DRIFT_MAX_INTERVAL && lError < TIMER_STEP_LIMIT + lReal * TIMER_DRIFT_LIMIT / 1000000000LL)
+        {
+            // a single telegram is up to 1 s off, the slope of a line through all telegrams is much more precise
+            double lX = lReal / 1000.0;
+            double lY = (double)(lLocal - lReal);
+            double lDeltaX = lX - mDriftMeanX;
+            mDriftSamples++;
+            mDriftMeanX += lDeltaX / mDriftSamples;
+            mDriftMeanY += (lY - mDriftMeanY) / mDriftSamples;
+            mDriftSumXX += lDeltaX * (lX - mDriftMeanX);
+            mDriftSumXY += lDeltaX * (lY - mDriftMeanY);
+            if (lReal >= TIMER_DRIFT_MIN_INTERVAL && mDriftSamples >= TIMER_DRIFT_MIN_SAMPLES)
+                mDriftPpb = (int32_t)(mDriftSumXY / mDriftSumXX * 1000000.0);
+            return;
+        }
+    }
+    mDriftAnchorTime = iBusTime;
+    mDriftAnchorMillis = iMillis;
+    mDriftSamples = 1;
+    mDriftMeanX = 0;
+    mDriftMeanY = 0;
+    mDriftSumXX = 0;
+    mDriftSumXY = 0;
 }
 
-sTime *TimerModule::getSunInfo(uint8_t iSunInfo)
+int32_t TimerModule::getClockDrift()
 {
-    if (iSunInfo == SUN_SUNRISE)
-        return &mSunrise;
-    else if (iSunInfo == SUN_SUNSET)
-        return &mSunset;
-    else
-        return NULL;
+    return mDriftPpb;
 }
 
-void TimerModule::getSunDegree(uint8_t iSunInfo, double iDegree, sTime *eSun)
+int32_t TimerModule::getClockOffset()
 {
-    double rise, set;
-    // sunrise/sunset calculation
-    sunRiseSet(getYear(), getMonth(), getDay(),
-               mLongitude, mLatitude, iDegree, 0, &rise, &set);
-    if (iSunInfo == SUN_SUNRISE)
-        convertToLocalTime(rise, eSun);
-    else if (iSunInfo == SUN_SUNSET)
-        convertToLocalTime(set, eSun);
+    return mClockOffset;
 }
 
-sDay *TimerModule::getEaster()
+uint32_t TimerModule::getLagCount()
 {
-    return &mEaster;
+    return mLagCount;
 }
 
-char *TimerModule::getTimeAsc()
+uint32_t TimerModule::getLagMax()
 {
-    return asctime(&mNow);
+    return mLagMax;
 }
 
-uint8_t TimerModule::holidayToday()
+void TimerModule::setDateTimeFromBus(tm *iDateTime)
 {
-    return mHolidayToday;
+    if (iDateTime->tm_hour > 23 || iDateTime->tm_min > 59 || iDateTime->tm_sec > 59 ||
+        iDateTime->tm_mon < 1 || iDateTime->tm_mon > 12 || iDateTime->tm_mday < 1 || iDateTime->tm_mday > TimerCalendar::daysInMonth(iDateTime->tm_year, iDateTime->tm_mon))
+        return;
+    acceptTime(TIMER_SOURCE_BUS, TIMER_BUS_DATE | TIMER_BUS_TIME, TimerCalendar::daysFromCivil(iDateTime->tm_year, iDateTime->tm_mon, iDateTime->tm_mday),
+                 iDateTime->tm_hour * 3600L + iDateTime->tm_min * 60 + iDateTime->tm_sec, TIMER_MILLIS());
 }
 
-uint8_t TimerModule::holidayTomorrow()
+bool TimerModule::minuteChanged()
 {
-    return mHolidayTomorrow;
+    return mMinuteChanged && isClockRunning();
 }
 
-bool TimerModule::holidayChanged()
+void TimerModule::clearMinuteChanged()
 {
-    return mHolidayChanged;
+    mMinuteChanged = false;
 }
 
-void TimerModule::clearHolidayChanged()
+uint16_t TimerModule::getYear()
 {
-    mHolidayChanged = false;
+    return mNow.year;
 }
 
-eTimeValid TimerModule::isTimerValid()
+uint8_t TimerModule::getMonth()
 {
-    return mTimeValid;
+    return mNow.month;
 }
 
-void TimerModule::setIsSummertime(bool iValue)
+uint8_t TimerModule::getDay()
 {
-    if (iValue != mIsSummertime)
-    {
-        mIsSummertime = iValue;
-        calculateSunriseSunset();
-    }
+    return mNow.day;
 }
 
-uint8_t TimerModule::calculateLastSundayInMonth(uint8_t iMonth)
+uint8_t TimerModule::getHour()
 {
-    mTimeHelper.tm_year = mNow.tm_year;
-    mTimeHelper.tm_mon = iMonth - 1;
-    mTimeHelper.tm_mday = 31;
-    mktime(&mTimeHelper);
-    return mTimeHelper.tm_mday - mTimeHelper.tm_wday;
+    return mNow.hour;
 }
 
-// should be called only at 03:01 o'clock
-void TimerModule::calculateSummertime()
+uint8_t TimerModule::getMinute()
 {
-    // first we do easy win
-    bool lIsSummertime = false;
-    if (mUseSummertime)
-    {
-        if (getMonth() == 3)
-        {
-            // find last Sunday in March
-            uint8_t lLastSunday = calculateLastSundayInMonth(3);
-            if (lLastSunday == mNow.tm_mday)
-            {
-                // we have to take time into account
-                lIsSummertime = (mNow.tm_hour > 3);
-            }
-            else
-            {
-                lIsSummertime = (lLastSunday < mNow.tm_mday);
-            }
-        }
-        else if (getMonth() == 10)
-        {
-            // find last Sunday in October
-            uint8_t lLastSunday = calculateLastSundayInMonth(10);
-            if (lLastSunday == mNow.tm_mday)
-            {
-                // we have to take time into account
-                // here might be a problem if called between
-                // 2 and 3, because these times exist in both
-                // summer and wintertime. This is currently
-                // mitigated with the fact, that this routine
-                // is called only once at 03:01. Currently just used
-                // for sunrise/sunset calculation, so calling
-                // time is no problem.
-                lIsSummertime = (mNow.tm_hour < 3);
-            }
-            else
-            {
-                lIsSummertime = (lLastSunday > mNow.tm_mday);
-            }
-        }
-        else
-        {
-            lIsSummertime = (getMonth() > 3 && getMonth() < 10);
-        }
-        setIsSummertime(lIsSummertime);
-    }
+    return mNow.minute;
 }
 
-void TimerModule::calculateAdvent()
+uint8_t TimerModule::getSecond()
 {
-    // calculates the 4th advent
-    mTimeHelper.tm_year = mNow.tm_year;
-    mTimeHelper.tm_mon = 11;
-    mTimeHelper.tm_mday = 24;
-    mTimeHelper.tm_hour = 12;
-    mTimeHelper.tm_min = 0;
-    mTimeHelper.tm_sec = 0;
-    mktime(&mTimeHelper); //   -timezone;
-    mAdvent.day = 24 - mTimeHelper.tm_wday;
-    mAdvent.month = 12;
-}
-
-void TimerModule::calculateEaster()
-{
-    uint16_t lYear = getYear();
-    uint8_t a = lYear % 19;
-    uint8_t b = lYear % 4;
-    uint8_t c = lYear % 7;
-
-    uint8_t k = lYear / 100;
-    uint8_t q = k / 4;
-    uint8_t p = ((8 * k) + 13) / 25;
-    uint8_t Egz = (38 - (k - q) + p) % 30; // Die Jahrhundertepakte
-    uint8_t M = (53 - Egz) % 30;
-    uint8_t N = (4 + k - q) % 7;
-
-    uint8_t d = ((19 * a) + M) % 30;
-    uint8_t e = ((2 * b) + (4 * c) + (6 * d) + N) % 7;
+    return mNow.second;
+}
 
+uint16_t TimerModule::getMinuteOfDay()
+{
+    return mNow.hour * 60 + mNow.minute;
+}
+
+// 1..366
+uint16_t TimerModule::getDayOfYear()
+{
+    return mNow.yearDay + 1;
+}
+
+uint8_t TimerModule::getIsoWeek()
+{
+    return TimerCalendar::isoWeek(mDayNumber);
+}
+
+// seconds since 1970-01-01 UTC
+uint32_t TimerModule::getEpoch()
+{
+    return mEpoch - getUtcOffset() * 60L;
+}
+
+// milliseconds since the last tick of the clock, might exceed a second if loop() is late
+uint32_t TimerModule::getMillisOfSecond()
+{
+    int32_t lFraction = (int32_t)(TIMER_MILLIS() - mTimeDelay);
+    return (lFraction < 0) ? 0 : lFraction;
+}
+
+// milliseconds since local midnight, the fraction of the second is taken from millis()
+uint32_t TimerModule::getMillisOfDay()
+{
+    return ((mEpoch % 86400) * 1000 + getMillisOfSecond()) % 86400000UL;
+}
+
+// milliseconds since 1970-01-01 UTC
+int64_t TimerModule::getEpochMillis()
+{
+    return (int64_t)getEpoch() * 1000LL + getMillisOfSecond();
+}
+
+uint32_t TimerModule::getMillisToNextMinute()
+{
+    return 60000 - (mNow.second * 1000 + getMillisOfSecond()) % 60000;
+}
+
+// milliseconds until the next occurrence of the given local time
+uint32_t TimerModule::getMillisUntil(uint8_t iHour, uint8_t iMinute, uint8_t iSecond)
+{
+    int32_t lDiff = (int32_t)((iHour * 3600UL + iMinute * 60 + iSecond) * 1000) - (int32_t)getMillisOfDay();
+    if (lDiff <= 0)
+        lDiff += 86400000L;
+    return lDiff;
+}
+
+uint8_t TimerModule::getWeekday()
+{
+    return mNow.weekday;
+}
+
+sTime *TimerModule::getSunInfo(uint8_t iSunInfo)
+{
+    if (iSunInfo == SUN_SUNRISE)
+        return &mSunrise;
+    else if (iSunInfo == SUN_SUNSET)
+        return &mSunset;
+    else
+        return NULL;
+}
+
+void TimerModule::getSunDegree(uint8_t iSunInfo, double iDegree, sTime *eSun)
+{
+    sSunCacheEntry *lEntry = getSunCacheEntry(iDegree, false);
+    if (iSunInfo == SUN_SUNRISE)
+        convertToLocalTime(lEntry->rise, eSun);
+    else if (iSunInfo == SUN_SUNSET)
+        convertToLocalTime(lEntry->set, eSun);
+}
+
+// returns +1 if the sun stays above the altitude all day, -1 if it stays below, 0 otherwise
+int8_t TimerModule::getSunDegree(double iDegree, bool iUpperLimb, sTime *eRise, sTime *eSet)
+{
+    sSunCacheEntry *lEntry = getSunCacheEntry(iDegree, iUpperLimb);
+    convertToLocalTime(lEntry->rise, eRise);
+    convertToLocalTime(lEntry->set, eSet);
+    return lEntry->rc;
+}
+
+// rise/set times of today for several altitudes at once, the terms of the day are calculated just once.
+// eRc receives +1 for polar day and -1 for polar night of each altitude, eNoon the time of the sun at south.
+void TimerModule::getSunTimes(const sSunAltitude *iAltitudes, uint8_t iCount, sTime (*eTimes)[2], int8_t *eRc, sTime *eNoon)
+{
+    for (uint8_t i = 0; i < iCount; i++)
+    {
+        int8_t lRc = getSunDegree(iAltitudes[i].degree, iAltitudes[i].upperLimb, &eTimes[i][SUN_SUNRISE], &eTimes[i][SUN_SUNSET]);
+        if (eRc)
+            eRc[i] = lRc;
+    }
+    if (eNoon)
+    {
+        // ensures the terms of today
+        getSunCacheEntry(-35.0f / 60.0f, true);
+        convertToLocalTime(sunNoon(mSunCacheTerms), eNoon);
+    }
+}
+
+// returns the cached rise/set times for the given altitude, calculates them on a miss.
+// Times are kept in UT, so just a new day or location invalidates the cache.
+sSunCacheEntry *TimerModule::getSunCacheEntry(float iDegree, bool iUpperLimb)
+{
+    if (mSunCacheDay != mDayNumber || mSunCacheLongitude != mLongitude || mSunCacheLatitude != mLatitude)
+    {
+        mSunCacheDay = mDayNumber;
+        mSunCacheLongitude = mLongitude;
+        mSunCacheLatitude = mLatitude;
+        mSunCacheCount = 0;
+        mSunCacheNext = 0;
+        sunDay(getYear(), getMonth(), getDay(), mLongitude, &mSunCacheTerms);
+    }
+    for (uint8_t i = 0; i < mSunCacheCount; i++)
+    {
+        if (mSunCache[i].degree == iDegree && mSunCache[i].upperLimb == iUpperLimb)
+        {
+            mSunCacheHits++;
+            return &mSunCache[i];
+        }
+    }
+    mSunCacheMisses++;
+    sSunCacheEntry *lEntry = &mSunCache[mSunCacheNext];
+    lEntry->degree = iDegree;
+    lEntry->upperLimb = iUpperLimb;
+    lEntry->rc = sunRiseSet(mSunCacheTerms, mLatitude, iDegree, iUpperLimb, &lEntry->rise, &lEntry->set);
+    if (mSunCacheCount < TIMER_SUN_CACHE_SIZE)
+        mSunCacheCount++;
+    mSunCacheNext = (mSunCacheNext + 1) % TIMER_SUN_CACHE_SIZE;
+    return lEntry;
+}
+
+uint32_t TimerModule::getSunCacheHits()
+{
+    return mSunCacheHits;
+}
+
+uint32_t TimerModule::getSunCacheMisses()
+{
+    return mSunCacheMisses;
+}
+
+#if defined(TIMER_SUN_FIXED) || defined(TIMER_SUN_FLOAT)
+typedef float sun_position_t;
+#else
+typedef double sun_position_t;
+#endif
+
+// azimuth (degrees from north over east) and elevation (degrees, without refraction) of the sun now.
+// RA, declination and GMST0 are calculated once per UT day, each call just evaluates the hour angle.
+void TimerModule::getSunPosition(float *eAzimuth, float *eElevation)
+{
+    typedef SunEngine<sun_position_t> Engine;
+    uint32_t lEpoch = getEpoch();
+    int32_t lDay = lEpoch / 86400;
+    if (lDay != mSunPositionDay.day)
+    {
+        // days since 2000 Jan 0.0, which is day number 10956
+        sun_position_t lD = lDay - 10956;
+        sun_position_t lR, lRA, lDec;
+        mSunPositionDay.day = lDay;
+        mSunPositionDay.gmst0 = Engine::GMST0(lD);
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            Engine::sunRadDec(lD + i, &lRA, &lDec, &lR);
+            mSunPositionDay.ra[i] = lRA;
+            mSunPositionDay.dec[i] = lDec;
+        }
+    }
+    sun_position_t lFraction = (sun_position_t)(lEpoch % 86400) / sun_position_t(86400.0);
+    sun_position_t lRA = mSunPositionDay.ra[0] + Engine::rev180(mSunPositionDay.ra[1] - mSunPositionDay.ra[0]) * lFraction;
+    sun_position_t lDec = mSunPositionDay.dec[0] + (mSunPositionDay.dec[1] - mSunPositionDay.dec[0]) * lFraction;
+    // GMST0 moves 0.9856 degrees per day in addition to the earth rotation
+    sun_position_t lSidtime = mSunPositionDay.gmst0 + sun_position_t(360.98564736) * lFraction + mLongitude;
+    sun_position_t lAzimuth, lElevation;
+    Engine::horizontal(lSidtime - lRA, lDec, mLatitude, &lAzimuth, &lElevation);
+    *eAzimuth = lAzimuth;
+    *eElevation = lElevation;
+}
+
+// sunrise/sunset in local time for any date, summertime is taken from the rules if they are used
+void TimerModule::getSunInfo(uint8_t iSunInfo, uint8_t iDay, uint8_t iMonth, uint16_t iYear, sTime *eSun)
+{
+    if (iSunInfo > SUN_SUNSET || iMonth < 1 || iMonth > 12 || iDay < 1 || iDay > TimerCalendar::daysInMonth(iYear, iMonth))
+        return;
+    int16_t lSun[2];
+    calculateSunriseSunset(iYear, iMonth, iDay, &lSun[SUN_SUNRISE], &lSun[SUN_SUNSET]);
+    convertToLocalTime(lSun[iSunInfo], TimerCalendar::daysFromCivil(iYear, iMonth, iDay), eSun);
+}
+
+sDay *TimerModule::getEaster()
+{
+    return &mEaster;
+}
+
+char *TimerModule::getTimeAsc()
+{
+    tm lTime;
+    getTime(&lTime);
+    return asctime(&lTime);
+}
+
+// local time as struct tm (tm_mon 0..11, tm_year since 1900)
+void TimerModule::getTime(tm *eTime)
+{
+    eTime->tm_sec = mNow.second;
+    eTime->tm_min = mNow.minute;
+    eTime->tm_hour = mNow.hour;
+    eTime->tm_mday = mNow.day;
+    eTime->tm_mon = mNow.month - 1;
+    eTime->tm_year = mNow.year - 1900;
+    eTime->tm_wday = mNow.weekday;
+    eTime->tm_yday = mNow.yearDay;
+    eTime->tm_isdst = mIsSummertime;
+}
+
+uint8_t TimerModule::holidayToday()
+{
+    return mHolidayToday;
+}
+
+uint8_t TimerModule::holidayTomorrow()
+{
+    return mHolidayTomorrow;
+}
+
+bool TimerModule::holidayChanged()
+{
+    return mHolidayChanged;
+}
+
+void TimerModule::clearHolidayChanged()
+{
+    mHolidayChanged = false;
+}
+
+eTimeValid TimerModule::isTimerValid()
+{
+    return mTimeValid;
+}
+
+// publishes the state for getSnapshot(), if it changed since the last call
+void TimerModule::updateSnapshot()
+{
+    if (!mSnapshotDirty && mSnapshotEpoch == mEpoch)
+        return;
+    // a new date is held back with the time, until its holidays and sun times are published
+    if (mRecalc.step != TIMER_RECALC_IDLE)
+        return;
+    sTimerSnapshot lSnapshot;
+    lSnapshot.now = mNow;
+    lSnapshot.epoch = getEpoch();
+    lSnapshot.utcOffset = getUtcOffset();
+    lSnapshot.valid = mTimeValid;
+    lSnapshot.summertime = mIsSummertime;
+    lSnapshot.provisional = mTimeProvisional;
+    lSnapshot.holidayToday = mHolidayToday;
+    lSnapshot.holidayTomorrow = mHolidayTomorrow;
+    lSnapshot.sunrise = mSunrise;
+    lSnapshot.sunset = mSunset;
+    mSnapshot.write(lSnapshot);
+    mSnapshotEpoch = mEpoch;
+    mSnapshotDirty = false;
+}
+
+void TimerModule::getSnapshot(sTimerSnapshot *eSnapshot)
+{
+    mSnapshot.read(eSnapshot);
+}
+
+// true while the time is restored from flash and not yet confirmed by a time telegram
+bool TimerModule::isTimeProvisional()
+{
+    return mTimeProvisional;
+}
+
+// timers run on a valid time and on a provisional time restored from flash
+bool TimerModule::isClockRunning()
+{
+    return mTimeValid == tmValid || mTimeProvisional;
+}
+
+uint16_t TimerModule::flashSize()
+{
+    return TIMER_FLASH_SIZE;
+}
+
+void TimerModule::writeFlash()
+{
+    openknx.flash.writeByte(TIMER_FLASH_VERSION);
+    // a provisional time is not saved again, otherwise the downtimes of several reboots add up
+    openknx.flash.writeByte((mTimeValid == tmValid && !mTimeProvisional) | (mIsSummertime << 1));
+    openknx.flash.writeInt(mEpoch);
+    openknx.flash.writeInt(mDriftPpb);
+}
+
+// restores the clock as provisional time, timers run immediately and are corrected by the next time telegram.
+// The downtime is unknown, so just the date is reported as valid, until a time telegram confirms the time.
+void TimerModule::readFlash(const uint8_t *iBuffer, const uint16_t iSize)
+{
+    if (iSize < TIMER_FLASH_SIZE || openknx.flash.readByte() != TIMER_FLASH_VERSION)
+        return;
+    uint8_t lFlags = openknx.flash.readByte();
+    uint32_t lEpoch = openknx.flash.readInt();
+    int32_t lDrift = openknx.flash.readInt();
+    if (lDrift > -TIMER_DRIFT_LIMIT && lDrift < TIMER_DRIFT_LIMIT)
+        mDriftPpb = lDrift;
+    // a time telegram received meanwhile is better than the stored time
+    if (!(lFlags & 0x01) || mTimeValid != tmInvalid)
+        return;
+    setEpoch(lEpoch);
+    mIsSummertime = lFlags & 0x02;
+    mDstMinute = 0;
+    mTimeDelay = TIMER_MILLIS();
+    mTimeValid = tmDateValid;
+    mTimeProvisional = true;
+    mEventsDirty = true;
+    mSnapshotDirty = true;
+}
+
+void TimerModule::setIsSummertime(bool iValue)
+{
+    if (iValue != mIsSummertime)
+    {
+        mIsSummertime = iValue;
+        calculateSunriseSunset();
+        mSnapshotDirty = true;
+        mEventsDirty = true;
+        mPendingChanges |= TIMER_CHANGE_SUMMERTIME;
+    }
+}
+
+// registers a callback, which is called from loop() for each of the given TIMER_CHANGE_* changes,
+// returns the listener id or -1. In contrast to minuteChanged()/holidayChanged() there is nothing to clear.
+int8_t TimerModule::addChangeListener(uint8_t iChanges, TimerChangeCallback iCallback, void *iContext)
+{
+    if (iCallback == nullptr || iChanges == 0)
+        return -1;
+    for (uint8_t i = 0; i < TIMER_MAX_LISTENERS; i++)
+    {
+        if (mListeners[i].callback == nullptr)
+        {
+            mListeners[i].callback = iCallback;
+            mListeners[i].context = iContext;
+            mListeners[i].changes = iChanges;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TimerModule::removeChangeListener(uint8_t iListenerId)
+{
+    if (iListenerId < TIMER_MAX_LISTENERS)
+        mListeners[iListenerId].callback = nullptr;
+}
+
+// called once per loop with all changes collected, so listeners see the state after all recalculations
+void TimerModule::notifyListeners()
+{
+    uint8_t lChanges = mPendingChanges;
+    mPendingChanges = 0;
+    for (uint8_t i = 0; i < TIMER_MAX_LISTENERS; i++)
+    {
+        if (mListeners[i].callback != nullptr && (mListeners[i].changes & lChanges))
+            mListeners[i].callback(lChanges & mListeners[i].changes, mListeners[i].context);
+    }
+}
+
+// registers a callback for a local time on the given weekdays (bit 0 = sunday), returns the event id or -1
+int8_t TimerModule::addTimeEvent(uint8_t iHour, uint8_t iMinute, uint8_t iWeekdays, TimerEventCallback iCallback, void *iContext)
+{
+    if (iHour > 23 || iMinute > 59)
+        return -1;
+    return addEvent(TIMER_EVENT_TIME, iHour * 60 + iMinute, iWeekdays, iCallback, iContext);
+}
+
+// registers a callback for sunrise/sunset plus iOffset minutes on the given weekdays, returns the event id or -1
+int8_t TimerModule::addSunEvent(uint8_t iSunInfo, int16_t iOffset, uint8_t iWeekdays, TimerEventCallback iCallback, void *iContext)
+{
+    if (iSunInfo > SUN_SUNSET)
+        return -1;
+    return addEvent((iSunInfo == SUN_SUNRISE) ? TIMER_EVENT_SUNRISE : TIMER_EVENT_SUNSET, iOffset, iWeekdays, iCallback, iContext);
+}
+
+int8_t TimerModule::addEvent(uint8_t iType, int16_t iMinute, uint8_t iWeekdays, TimerEventCallback iCallback, void *iContext)
+{
+    if (iCallback == nullptr || (iWeekdays & TIMER_WEEKDAYS_ALL) == 0)
+        return -1;
+    for (uint8_t i = 0; i < TIMER_MAX_EVENTS; i++)
+    {
+        if (mEvents[i].callback == nullptr)
+        {
+            // the slot of a removed event may still be in the heap, it is dropped while the callback is unset
+            if (isEventQueued(i))
+                purgeEvents();
+            mEvents[i].callback = iCallback;
+            mEvents[i].context = iContext;
+            mEvents[i].type = iType;
+            mEvents[i].minute = iMinute;
+            mEvents[i].weekdays = iWeekdays;
+            // just fire times of new events are calculated, if the time is already valid
+            if (isClockRunning() && !mEventsDirty)
+            {
+                mEvents[i].nextFire = calculateNextFire(mEvents[i], mDayNumber * 1440 + getHour() * 60 + getMinute());
+                pushEvent(i);
+            }
+            else
+                mEventsDirty = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TimerModule::removeEvent(uint8_t iEventId)
+{
+    if (iEventId >= TIMER_MAX_EVENTS || mEvents[iEventId].callback == nullptr)
+        return;
+    // the heap entry is dropped, when it is due
+    mEvents[iEventId].callback = nullptr;
+}
+
+// first fire time after iNow (both in local minutes since 1970-01-01), 0 if there is none within a week
+uint32_t TimerModule::calculateNextFire(sTimerEvent &iEvent, uint32_t iNow)
+{
+    int32_t lDayNumber = iNow / 1440;
+    for (uint8_t lDay = 0; lDay <= 7; lDay++, lDayNumber++)
+    {
+        if (!(iEvent.weekdays & (1 << TimerCalendar::weekday(lDayNumber))))
+            continue;
+        int16_t lMinute = iEvent.minute;
+        if (iEvent.type != TIMER_EVENT_TIME)
+        {
+            int16_t lYear;
+            uint8_t lMonth, lDayOfMonth;
+            int16_t lSun[2];
+            TimerCalendar::civilFromDays(lDayNumber, lYear, lMonth, lDayOfMonth);
+            calculateSunriseSunset(lYear, lMonth, lDayOfMonth, &lSun[SUN_SUNRISE], &lSun[SUN_SUNSET]);
+            lMinute += toLocalMinutes(lSun[(iEvent.type == TIMER_EVENT_SUNRISE) ? SUN_SUNRISE : SUN_SUNSET], lDayNumber);
+        }
+        int32_t lFire = lDayNumber * 1440 + lMinute;
+        if (lFire > (int32_t)iNow)
+            return lFire;
+    }
+    return 0;
+}
+
+#if TIMER_MAX_RULES > 0
+// registers a rule for a fixed local time, returns the rule id or -1
+int16_t TimerModule::addTimeRule(uint8_t iHour, uint8_t iMinute, uint8_t iWeekdays, uint16_t iMonths, uint8_t iHolidays)
+{
+    if (iHour > 23 || iMinute > 59)
+        return -1;
+    return addRule(TIMER_EVENT_TIME, iHour * 60 + iMinute, -1, -1, iWeekdays, iMonths, iHolidays);
+}
+
+// registers a rule for sunrise/sunset plus iOffset minutes, limited to iEarliest..iLatest (minute of day, -1 for no limit)
+int16_t TimerModule::addSunRule(uint8_t iSunInfo, int16_t iOffset, int16_t iEarliest, int16_t iLatest, uint8_t iWeekdays, uint16_t iMonths, uint8_t iHolidays)
+{
+    if (iSunInfo > SUN_SUNSET || iEarliest >= 1440 || iLatest >= 1440)
+        return -1;
+    return addRule((iSunInfo == SUN_SUNRISE) ? TIMER_EVENT_SUNRISE : TIMER_EVENT_SUNSET, iOffset, iEarliest, iLatest, iWeekdays, iMonths, iHolidays);
+}
+
+int16_t TimerModule::addRule(uint8_t iType, int16_t iMinute, int16_t iEarliest, int16_t iLatest, uint8_t iWeekdays, uint16_t iMonths, uint8_t iHolidays)
+{
+    if ((iWeekdays & TIMER_WEEKDAYS_ALL) == 0 || (iMonths & TIMER_MONTHS_ALL) == 0 || iHolidays > TIMER_RULE_HOLIDAY_SUNDAY)
+        return -1;
+    for (uint16_t i = 0; i < TIMER_MAX_RULES; i++)
+    {
+        if (mRules[i].used)
+            continue;
+        mRules[i] = {iMinute, iEarliest, iLatest, iType, true};
+        uint16_t lWord = i >> 5;
+        uint32_t lBit = 1UL << (i & 31);
+        for (uint8_t lDay = 0; lDay < 7; lDay++)
+            if (iWeekdays & (1 << lDay))
+                mRulesWeekday[lDay][lWord] |= lBit;
+        for (uint8_t lMonth = 0; lMonth < 12; lMonth++)
+            if (iMonths & (1 << lMonth))
+                mRulesMonth[lMonth][lWord] |= lBit;
+        mRulesHoliday[iHolidays][lWord] |= lBit;
+        mRulesDirty = true;
+        return i;
+    }
+    return -1;
+}
+
+void TimerModule::removeRule(uint16_t iRuleId)
+{
+    if (iRuleId >= TIMER_MAX_RULES || !mRules[iRuleId].used)
+        return;
+    mRules[iRuleId].used = false;
+    uint16_t lWord = iRuleId >> 5;
+    uint32_t lMask = ~(1UL << (iRuleId & 31));
+    for (uint8_t i = 0; i < 7; i++)
+        mRulesWeekday[i][lWord] &= lMask;
+    for (uint8_t i = 0; i < 12; i++)
+        mRulesMonth[i][lWord] &= lMask;
+    for (uint8_t i = 0; i < 4; i++)
+        mRulesHoliday[i][lWord] &= lMask;
+    mRulesDue[lWord] &= lMask;
+    mRulesDirty = true;
+}
+
+bool TimerModule::isRuleDue(uint16_t iRuleId)
+{
+    return iRuleId < TIMER_MAX_RULES && (mRulesDue[iRuleId >> 5] & (1UL << (iRuleId & 31)));
+}
+
+const uint32_t *TimerModule::getRulesDue()
+{
+    return mRulesDue;
+}
+
+// selects the rules of today by their weekday, month and holiday bitsets and sorts their fire minutes
+void TimerModule::compileRules()
+{
+    int16_t lSun[2] = {(int16_t)(mSunrise.hour * 60 + mSunrise.minute), (int16_t)(mSunset.hour * 60 + mSunset.minute)};
+    int16_t lNow = getMinuteOfDay();
+    // a list compiled again during the day does not fire the past minutes again
+    bool lSameDay = (mRulesDay == mDayNumber);
+    bool lSkipNow = lSameDay && mRulesMinute == lNow;
+    if (!lSameDay)
+        mRulesMinute = -1;
+    mRuleFireCount = 0;
+    mRuleFireNext = 0;
+    for (uint16_t lWord = 0; lWord < TIMER_RULE_WORDS; lWord++)
+    {
+        uint32_t lActive;
+        if (mHolidayToday)
+            lActive = (mRulesWeekday[mNow.weekday][lWord] & mRulesHoliday[TIMER_RULE_HOLIDAY_IGNORE][lWord]) |
+                      (mRulesWeekday[0][lWord] & mRulesHoliday[TIMER_RULE_HOLIDAY_SUNDAY][lWord]) |
+                      mRulesHoliday[TIMER_RULE_HOLIDAY_ONLY][lWord];
+        else
+            lActive = mRulesWeekday[mNow.weekday][lWord] & ~mRulesHoliday[TIMER_RULE_HOLIDAY_ONLY][lWord];
+        lActive &= mRulesMonth[mNow.month - 1][lWord];
+        while (lActive)
+        {
+            uint16_t lRuleId = (lWord << 5) + __builtin_ctz(lActive);
+            lActive &= lActive - 1;
+            const sTimerRule &lRule = mRules[lRuleId];
+            int16_t lMinute = lRule.minute;
+            if (lRule.type != TIMER_EVENT_TIME)
+            {
+                lMinute += lSun[(lRule.type == TIMER_EVENT_SUNRISE) ? SUN_SUNRISE : SUN_SUNSET];
+                if (lRule.earliest >= 0 && lMinute < lRule.earliest)
+                    lMinute = lRule.earliest;
+                if (lRule.latest >= 0 && lMinute > lRule.latest)
+                    lMinute = lRule.latest;
+            }
+            if (lMinute < 0 || lMinute >= 1440)
+                continue;
+            uint16_t lPos = mRuleFireCount++;
+            while (lPos > 0 && mRuleFireMinute[lPos - 1] > lMinute)
+            {
+                mRuleFireMinute[lPos] = mRuleFireMinute[lPos - 1];
+                mRuleFireId[lPos] = mRuleFireId[lPos - 1];
+                lPos--;
+            }
+            mRuleFireMinute[lPos] = lMinute;
+            mRuleFireId[lPos] = lRuleId;
+            if (lMinute < lNow || (lMinute == lNow && lSkipNow))
+                mRuleFireNext++;
+        }
+    }
+    mRulesDay = mDayNumber;
+    mRulesDirty = false;
+}
+
+// marks the rules due in the current minute, just the head of the fire list is checked
+void TimerModule::processRules()
+{
+    // holidays and sun times of a new day have to be published first
+    if (mRecalc.step != TIMER_RECALC_IDLE)
+        return;
+    if (mRulesDirty || mRulesDay != mDayNumber)
+        compileRules();
+    int16_t lNow = getMinuteOfDay();
+    if (lNow == mRulesMinute)
+        return;
+    mRulesMinute = lNow;
+    memset(mRulesDue, 0, sizeof(mRulesDue));
+    while (mRuleFireNext < mRuleFireCount && mRuleFireMinute[mRuleFireNext] <= lNow)
+    {
+        uint16_t lRuleId = mRuleFireId[mRuleFireNext++];
+        mRulesDue[lRuleId >> 5] |= 1UL << (lRuleId & 31);
+        mPendingChanges |= TIMER_CHANGE_RULES;
+    }
+}
+#endif
+
+void TimerModule::pushEvent(uint8_t iEventId)
+{
+    // each event is queued at most once, so this is just a guard
+    if (mEventHeapSize >= TIMER_MAX_EVENTS)
+        return;
+    uint32_t lFire = mEvents[iEventId].nextFire;
+    uint8_t lPos = mEventHeapSize++;
+    while (lPos > 0)
+    {
+        uint8_t lParent = (lPos - 1) / 2;
+        if (mEvents[mEventHeap[lParent]].nextFire <= lFire)
+            break;
+        mEventHeap[lPos] = mEventHeap[lParent];
+        lPos = lParent;
+    }
+    mEventHeap[lPos] = iEventId;
+}
+
+uint8_t TimerModule::popEvent()
+{
+    uint8_t lResult = mEventHeap[0];
+    uint8_t lLast = mEventHeap[--mEventHeapSize];
+    uint32_t lFire = mEvents[lLast].nextFire;
+    uint8_t lPos = 0;
+    while (true)
+    {
+        uint8_t lChild = 2 * lPos + 1;
+        if (lChild >= mEventHeapSize)
+            break;
+        if (lChild + 1 < mEventHeapSize && mEvents[mEventHeap[lChild + 1]].nextFire < mEvents[mEventHeap[lChild]].nextFire)
+            lChild++;
+        if (lFire <= mEvents[mEventHeap[lChild]].nextFire)
+            break;
+        mEventHeap[lPos] = mEventHeap[lChild];
+        lPos = lChild;
+    }
+    mEventHeap[lPos] = lLast;
+    return lResult;
+}
+
+bool TimerModule::isEventQueued(uint8_t iEventId)
+{
+    for (uint8_t i = 0; i < mEventHeapSize; i++)
+    {
+        if (mEventHeap[i] == iEventId)
+            return true;
+    }
+    return false;
+}
+
+// drops removed events from the heap, the fire times are kept
+void TimerModule::purgeEvents()
+{
+    uint8_t lSize = mEventHeapSize;
+    mEventHeapSize = 0;
+    // pushEvent() writes just positions, which are already read
+    for (uint8_t i = 0; i < lSize; i++)
+    {
+        uint8_t lEventId = mEventHeap[i];
+        if (mEvents[lEventId].callback != nullptr)
+            pushEvent(lEventId);
+    }
+}
+
+// recalculates all fire times, necessary after time, date or summertime changes
+void TimerModule::rebuildEvents()
+{
+    uint32_t lNow = mDayNumber * 1440 + getHour() * 60 + getMinute();
+    // events between the last processed minute and now are still due, a small
+    // backward step does not repeat the events already fired
+    uint32_t lFrom = lNow;
+    if (mEventsMinute > 0 && mEventsMinute + TIMER_EVENT_CATCHUP >= lNow && mEventsMinute <= lNow + TIMER_EVENT_CATCHUP)
+        lFrom = mEventsMinute;
+    mEventHeapSize = 0;
+    for (uint8_t i = 0; i < TIMER_MAX_EVENTS; i++)
+    {
+        if (mEvents[i].callback == nullptr)
+            continue;
+        // an event of an already processed minute is not fired again
+        mEvents[i].nextFire = calculateNextFire(mEvents[i], lFrom);
+        if (mEvents[i].nextFire)
+            pushEvent(i);
+    }
+    mEventsDirty = false;
+#if TIMER_MAX_RULES > 0
+    mRulesDirty = true;
+#endif
+}
+
+// fires all due events, usually just the head of the heap is checked
+void TimerModule::processEvents()
+{
+    if (mEventsDirty)
+        rebuildEvents();
+    uint32_t lNow = mDayNumber * 1440 + getHour() * 60 + getMinute();
+    while (mEventHeapSize > 0 && mEvents[mEventHeap[0]].nextFire <= lNow)
+    {
+        uint8_t lEventId = popEvent();
+        sTimerEvent &lEvent = mEvents[lEventId];
+        // removed event
+        if (lEvent.callback == nullptr)
+            continue;
+        // queued again before the callback, which might remove or replace the event
+        TimerEventCallback lCallback = lEvent.callback;
+        void *lContext = lEvent.context;
+        lEvent.nextFire = calculateNextFire(lEvent, lNow);
+        if (lEvent.nextFire)
+            pushEvent(lEventId);
+        // a changed time rebuilds the heap with the next call, the other events of this minute are fired anyway
+        lCallback(lEventId, lContext);
+    }
+    mEventsMinute = lNow;
+}
+
+// transitions of the given year in local minutes since 1970-01-01
+void TimerModule::calculateDstTransitions(int16_t iYear, uint32_t *eStart, uint32_t *eEnd)
+{
+    const sDstRule &lStart = mTimezoneRule.start;
+    const sDstRule &lEnd = mTimezoneRule.end;
+    *eStart = TimerCalendar::nthWeekday(iYear, lStart.month, lStart.week, lStart.weekday) * 1440 + lStart.minute;
+    *eEnd = TimerCalendar::nthWeekday(iYear, lEnd.month, lEnd.week, lEnd.weekday) * 1440 + lEnd.minute;
+}
+
+// iCurrent is the summertime state before, it resolves the hour, which exists twice at the end of summertime
+bool TimerModule::isSummertimeAt(uint32_t iLocalMinute, bool iCurrent)
+{
+    if (mTimezoneRule.dstOffset == 0)
+        return false;
+    uint32_t lStart = mDstStart;
+    uint32_t lEnd = mDstEnd;
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(iLocalMinute / 1440, lYear, lMonth, lDay);
+    if (lYear != mDstYear)
+        calculateDstTransitions(lYear, &lStart, &lEnd);
+    bool lResult;
+    if (lStart < lEnd)
+        lResult = (iLocalMinute >= lStart && iLocalMinute < lEnd);
+    else // southern hemisphere
+        lResult = (iLocalMinute >= lStart || iLocalMinute < lEnd);
+    // once switched back to standard time, the repeated hour stays standard time
+    if (lResult && !iCurrent && iLocalMinute < lEnd && iLocalMinute + mTimezoneRule.dstOffset >= lEnd)
+        lResult = false;
+    return lResult;
+}
+
+// called each minute, just compares the current time with the transitions of the year
+void TimerModule::calculateSummertime()
+{
+    if (!mUseSummertime)
+        return;
+    if (mDstYear != getYear())
+    {
+        calculateDstTransitions(getYear(), &mDstStart, &mDstEnd);
+        mDstYear = getYear();
+    }
+    uint32_t lNow = mDayNumber * 1440 + getHour() * 60 + getMinute();
+    bool lSummertime = isSummertimeAt(lNow, mIsSummertime);
+    // the running clock crossed the transition, so the wall clock is moved by the summertime offset,
+    // a clock set by the bus or restored from flash shows local time already
+    uint32_t lTransition = lSummertime ? mDstStart : mDstEnd;
+    if (lSummertime != mIsSummertime && mDstMinute > 0 && mDstMinute < lTransition && lTransition <= lNow)
+    {
+        uint32_t lEpoch = mEpoch + (lSummertime ? 60L : -60L) * mTimezoneRule.dstOffset;
+        if (lEpoch / 86400 != (uint32_t)mDayNumber)
+            setDate(lEpoch / 86400);
+        setEpoch(lEpoch);
+        // the hour is signaled here, the minute was signaled by the caller already
+        if (mHourTick != mNow.hour)
+            mPendingChanges |= TIMER_CHANGE_HOUR;
+        mHourTick = mNow.hour;
+        mMinuteTick = mNow.minute;
+        lNow = mDayNumber * 1440 + getHour() * 60 + getMinute();
+    }
+    setIsSummertime(lSummertime);
+    mDstMinute = lNow;
+}
+
+// current offset of local time to UT in minutes
+int16_t TimerModule::getUtcOffset()
+{
+    return mTimezoneRule.offset + ((mIsSummertime) ? mTimezoneRule.dstOffset : 0);
+}
+
+// offset of local time to UT in minutes for any day, summertime is taken from the rules if they are used
+int16_t TimerModule::getUtcOffset(int32_t iDayNumber, int16_t iUtMinute)
+{
+    if (!mUseSummertime)
+        return getUtcOffset();
+    if (isSummertimeAt(iDayNumber * 1440 + iUtMinute + mTimezoneRule.offset))
+        return mTimezoneRule.offset + mTimezoneRule.dstOffset;
+    return mTimezoneRule.offset;
+}
+
+void TimerModule::setTimezone(const sTimezoneRule &iRule)
+{
+    mTimezoneRule = iRule;
+    mTimezone = iRule.offset / 60;
+    mTimezoneSet = true;
+    mDstYear = -1;
+    if (isClockRunning())
+        calculateSummertime();
+    calculateSunriseSunset();
+    mEventsDirty = true;
+    mSnapshotDirty = true;
+}
+
+// parses [+-]hh[:mm] into minutes
+static bool parseTzTime(const char *&iPos, int16_t &eMinutes)
+{
+    int8_t lSign = 1;
+    if (*iPos == '+' || *iPos == '-')
+        lSign = (*iPos++ == '-') ? -1 : 1;
+    if (*iPos < '0' || *iPos > '9')
+        return false;
+    int16_t lHours = 0;
+    while (*iPos >= '0' && *iPos <= '9')
+        lHours = lHours * 10 + (*iPos++ - '0');
+    int16_t lMinutes = 0;
+    if (*iPos == ':')
+    {
+        iPos++;
+        while (*iPos >= '0' && *iPos <= '9')
+            lMinutes = lMinutes * 10 + (*iPos++ - '0');
+    }
+    eMinutes = lSign * (lHours * 60 + lMinutes);
+    return true;
+}
+
+// parses Mm.w.d[/time] into a rule
+static bool parseTzRule(const char *&iPos, sDstRule &eRule, int16_t iDefaultMinute)
+{
+    if (*iPos++ != 'M')
+        return false;
+    uint8_t lValues[3] = {0, 0, 0};
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (i > 0 && *iPos++ != '.')
+            return false;
+        if (*iPos < '0' || *iPos > '9')
+            return false;
+        while (*iPos >= '0' && *iPos <= '9')
+            lValues[i] = lValues[i] * 10 + (*iPos++ - '0');
+    }
+    if (lValues[0] < 1 || lValues[0] > 12 || lValues[1] < 1 || lValues[1] > 5 || lValues[2] > 6)
+        return false;
+    eRule.month = lValues[0];
+    eRule.week = lValues[1];
+    eRule.weekday = lValues[2];
+    eRule.minute = iDefaultMinute;
+    if (*iPos == '/')
+        return parseTzTime(++iPos, eRule.minute);
+    return true;
+}
+
+// skips a zone name like CET or <+0530>
+static bool parseTzName(const char *&iPos)
+{
+    if (*iPos == '<')
+    {
+        while (*iPos && *iPos != '>')
+            iPos++;
+        return *iPos++ == '>';
+    }
+    const char *lStart = iPos;
+    while ((*iPos >= 'A' && *iPos <= 'Z') || (*iPos >= 'a' && *iPos <= 'z'))
+        iPos++;
+    return iPos - lStart >= 3;
+}
+
+// sets timezone and summertime rules from a POSIX TZ string like "CET-1CEST,M3.5.0,M10.5.0/3",
+// just the M format is supported for transitions
+bool TimerModule::setTimezone(const char *iPosixTz)
+{
+    sTimezoneRule lRule = {0, 0, {3, 5, 0, 120}, {10, 5, 0, 180}};
+    const char *lPos = iPosixTz;
+    int16_t lOffset;
+    if (!parseTzName(lPos) || !parseTzTime(lPos, lOffset))
+        return false;
+    // POSIX offsets are west positive
+    lRule.offset = -lOffset;
+    if (*lPos)
+    {
+        if (!parseTzName(lPos))
+            return false;
+        lRule.dstOffset = 60;
+        if (*lPos && *lPos != ',')
+        {
+            if (!parseTzTime(lPos, lOffset))
+                return false;
+            lRule.dstOffset = -lOffset - lRule.offset;
+        }
+        if (*lPos == ',')
+        {
+            lPos++;
+            if (!parseTzRule(lPos, lRule.start, 120) || *lPos++ != ',' || !parseTzRule(lPos, lRule.end, 120))
+                return false;
+        }
+        if (*lPos)
+            return false;
+    }
+    setTimezone(lRule);
+    return true;
+}
+
+void TimerModule::calculateAdvent(int16_t iYear, sDay *eAdvent)
+{
+    // calculates the 4th advent
+    if (iYear >= MINYEAR && iYear <= TIMER_TABLE_MAXYEAR)
+        eAdvent->day = 18 + (cEasterAdventTable.entry[iYear - MINYEAR] >> 6);
+    else
+        eAdvent->day = TimerCalendar::adventDay(iYear);
+    eAdvent->month = 12;
+}
+
+void TimerModule::calculateEaster(int16_t iYear, sDay *eEaster)
+{
+    uint8_t lOffset;
+    if (iYear >= MINYEAR && iYear <= TIMER_TABLE_MAXYEAR)
+        lOffset = cEasterAdventTable.entry[iYear - MINYEAR] & 0x3F;
+    else
+        lOffset = TimerCalendar::easterOffset(iYear);
     // Ausrechnen des Ostertermins:
-    if ((22 + d + e) <= 31)
+    if (lOffset <= 9)
     {
-        mEaster.day = 22 + d + e;
-        mEaster.month = 3;
+        eEaster->day = 22 + lOffset;
+        eEaster->month = 3;
     }
     else
     {
-        mEaster.day = d + e - 9;
-        mEaster.month = 4;
-
-        // Zwei Ausnahmen berücksichtigen:
-        if (mEaster.day == 26)
-            mEaster.day = 19;
-        else if ((mEaster.day == 25) && (d == 28) && (a > 10))
-            mEaster.day = 18;
+        eEaster->day = lOffset - 9;
+        eEaster->month = 4;
     }
 }
 
@@ -496,290 +1847,433 @@ void TimerModule::debug()
 #endif
 }
 
-void TimerModule::calculateHolidays(bool iDebugOutput)
+bool TimerModule::processCommand(const std::string iCmd, bool iDiagnoseKo)
 {
-    // we check only if date is valid
-    if (mTimeValid < tmDateValid)
-        return;
-    // check if today or tomorrow is a holiday
-    sDay lToday = {(int8_t)getDay(), (int8_t)getMonth()};
-    sDay lTomorrow = getDayByOffset(1, lToday);
-    uint8_t lHolidayToday = 0;
-    uint8_t lHolidayTomorrow = 0;
-    for (uint8_t i = 0; i < cHolidaysCount; i++)
-    {
-        sDay lHoliday = {REMOVED, REMOVED};
-        switch (cHolidays[i].month)
+    if (iCmd == "timer")
+    {
+        debug();
+        return true;
+    }
+    if (iCmd == "timer stats")
+    {
+#ifdef TIMER_STATS
+        showStats();
+#else
+        logInfo("LogicTimer", "Statistics not compiled in (TIMER_STATS)");
+#endif
+        return true;
+    }
+#ifdef TIMER_STATS
+    if (iCmd == "timer stats reset")
+    {
+        memset(mStats, 0, sizeof(mStats));
+        memset(mCounters, 0, sizeof(mCounters));
+        return true;
+    }
+#endif
+    return false;
+}
+
+void TimerModule::showHelp()
+{
+    openknx.console.printHelpLine("timer", "Show current time, holidays and sun times");
+    openknx.console.printHelpLine("timer stats", "Show runtime statistics of the timer");
+#ifdef TIMER_STATS
+    openknx.console.printHelpLine("timer stats reset", "Reset runtime statistics of the timer");
+#endif
+}
+
+#ifdef TIMER_STATS
+void TimerModule::showStats()
+{
+    static const char *cStatNames[TIMER_STAT_COUNT] = {"loop", "year", "day", "holidays", "sunRiseSet", "processInputKo"};
+    logInfo("LogicTimer", "%-15s %10s %12s %8s %8s %8s", "", "count", "total us", "avg us", "max us", "last us");
+    for (uint8_t i = 0; i < TIMER_STAT_COUNT; i++)
+    {
+        sTimerStat &lStat = mStats[i];
+        logInfo("LogicTimer", "%-15s %10lu %12llu %8lu %8lu %8lu", cStatNames[i], (unsigned long)lStat.count, (unsigned long long)lStat.total,
+                (unsigned long)(lStat.count ? lStat.total / lStat.count : 0), (unsigned long)lStat.max, (unsigned long)lStat.last);
+    }
+    logInfo("LogicTimer", "syncs %lu, steps %lu, slews %lu, lag %lu/%lus, source %d (switches %lu, rejects %lu)",
+            (unsigned long)mCounters[TIMER_COUNT_SYNC], (unsigned long)mCounters[TIMER_COUNT_STEP], (unsigned long)mCounters[TIMER_COUNT_SLEW],
+            (unsigned long)mLagCount, (unsigned long)mLagMax, mMasterSource, (unsigned long)mSourceSwitches, (unsigned long)mSourceRejects);
+}
+#endif
+
+// builds the holiday bitmap of the given year
+void TimerModule::calculateHolidayMap(int16_t iYear, const sDay &iEaster, const sDay &iAdvent, uint32_t iHolidayMask, sHolidayMap *eMap)
+{
+    int16_t lYear = iYear;
+    int32_t lNewYear = TimerCalendar::daysFromCivil(lYear, 1, 1);
+    uint16_t lDays[TIMER_HOLIDAY_COUNT];
+    uint8_t lIds[TIMER_HOLIDAY_COUNT];
+    uint8_t lCount = 0;
+    for (uint8_t i = 0; i < TIMER_HOLIDAY_COUNT; i++)
+    {
+        if (!(iHolidayMask & HOLIDAY_BIT(i + 1)))
+            continue;
+        uint16_t lRule = cHolidayRules[i];
+        int16_t lOffset = (int16_t)(lRule << 7) >> 7;
+        int32_t lDay;
+        switch (lRule & HOLIDAY_TYPE_MASK)
         {
-            case REMOVED:
-                // do nothing
+            case HOLIDAY_TYPE_EASTER:
+                lDay = TimerCalendar::daysFromCivil(lYear, iEaster.month, iEaster.day + lOffset);
                 break;
-            case EASTER:
-                lHoliday = getDayByOffset(cHolidays[i].day, mEaster);
+            case HOLIDAY_TYPE_ADVENT:
+                lDay = TimerCalendar::daysFromCivil(lYear, iAdvent.month, iAdvent.day + lOffset);
                 break;
-            case ADVENT:
-                lHoliday = getDayByOffset(cHolidays[i].day, mAdvent);
-                // do nothing
+            case HOLIDAY_TYPE_WEEKDAY_BEFORE:
+                // last given weekday before the given date
+                lDay = TimerCalendar::daysFromCivil(lYear, (lRule >> 5) & 0x0F, lRule & 0x1F) - 1;
+                lDay -= (TimerCalendar::weekday(lDay) - ((lRule >> 9) & 0x07) + 7) % 7;
                 break;
             default:
                 // constant holiday
-                lHoliday = cHolidays[i];
+                lDay = TimerCalendar::daysFromCivil(lYear, (lRule >> 5) & 0x0F, lRule & 0x1F);
                 break;
         }
-        if (lHoliday.month > REMOVED)
+        lDay -= lNewYear;
+        if (lDay < 0 || lDay >= TimerCalendar::daysInYear(lYear))
+            continue;
+        // insertion sort by day of year, if 2 holidays fall on the same day, the later one in cHolidayRules wins
+        uint8_t lPos = lCount;
+        while (lPos > 0 && lDays[lPos - 1] > lDay)
+            lPos--;
+        if (lPos > 0 && lDays[lPos - 1] == lDay)
         {
-            if (iDebugOutput)
-                logInfo("LogicTimer", "%02d.%02d., ", lHoliday.day, lHoliday.month);
-            if (isEqualDate(lHoliday, lToday))
-                lHolidayToday = i + 1;
-            if (isEqualDate(lHoliday, lTomorrow))
-                lHolidayTomorrow = i + 1;
-            if (lHolidayToday > 0 && lHolidayTomorrow > 0 && !iDebugOutput)
-                break;
+            lIds[lPos - 1] = i + 1;
+            continue;
+        }
+        for (uint8_t j = lCount; j > lPos; j--)
+        {
+            lDays[j] = lDays[j - 1];
+            lIds[j] = lIds[j - 1];
         }
+        lDays[lPos] = lDay;
+        lIds[lPos] = i + 1;
+        lCount++;
     }
-    if (lHolidayToday != mHolidayToday)
+    memset(eMap->bits, 0, sizeof(eMap->bits));
+    for (uint8_t i = 0; i < lCount; i++)
     {
-        mHolidayToday = lHolidayToday;
-        mHolidayChanged = true;
+        eMap->bits[lDays[i] >> 5] |= 1UL << (lDays[i] & 31);
+        eMap->ids[i] = lIds[i];
     }
-    if (lHolidayTomorrow != mHolidayTomorrow)
+    eMap->year = lYear;
+}
+
+// selects the active holidays, holiday 1 is the most significant bit
+void TimerModule::setHolidayMask(uint32_t iMask)
+{
+    mHolidayMask = iMask;
+    mHolidayMap.year = -1;
+    mRecalc.holidays.year = -1;
+    // a configuration change is not time critical, it is applied at once
+    if (mTimeValid & tmDateValid)
     {
-        mHolidayTomorrow = lHolidayTomorrow;
-        mHolidayChanged = true;
+        startRecalc(false);
+        processRecalc(UINT32_MAX);
     }
 }
 
-bool TimerModule::isEqualDate(sDay &iDate1, sDay &iDate2)
+bool TimerModule::setHolidayRegion(uint8_t iRegion)
 {
-    return (iDate1.day == iDate2.day && iDate1.month == iDate2.month);
+    if (iRegion >= TIMER_REGION_COUNT)
+        return false;
+    setHolidayMask(cHolidayRegions[iRegion]);
+    return true;
 }
 
-sDay TimerModule::getDayByOffset(int8_t iOffset, sDay &iDate)
+uint32_t TimerModule::getHolidayMask()
 {
-    mTimeHelper.tm_year = mNow.tm_year;
-    mTimeHelper.tm_mon = iDate.month - 1;
-    mTimeHelper.tm_mday = iDate.day + iOffset;
-    mTimeHelper.tm_hour = 12;
-    mTimeHelper.tm_min = 0;
-    mTimeHelper.tm_sec = 0;
+    return mHolidayMask;
+}
 
-    // save a little time, if we are for sure within same month
-    if (mTimeHelper.tm_mday < 1 || mTimeHelper.tm_mday > 28)
-        mktime(&mTimeHelper); //   -timezone;
+// returns the holiday number of the given day of the current year or 0
+uint8_t TimerModule::getHolidayAt(uint16_t iDayOfYear)
+{
+    if (mHolidayMap.year != getYear())
+        return 0;
+    return getHolidayAt(mHolidayMap, iDayOfYear);
+}
 
-    // time_t nt_seconds = mktime(&mTimeHelper);     //   -timezone;
-    //  return gmtime(&nt_seconds);
+uint8_t TimerModule::getHolidayAt(const sHolidayMap &iMap, uint16_t iDayOfYear)
+{
+    if (iDayOfYear >= 366)
+        return 0;
+    uint8_t lWord = iDayOfYear >> 5;
+    uint32_t lBit = 1UL << (iDayOfYear & 31);
+    if (!(iMap.bits[lWord] & lBit))
+        return 0;
+    // the rank of the bit is the index into the holiday id table
+    uint8_t lRank = __builtin_popcount(iMap.bits[lWord] & (lBit - 1));
+    for (uint8_t i = 0; i < lWord; i++)
+        lRank += __builtin_popcount(iMap.bits[i]);
+    return iMap.ids[lRank];
+}
 
-    sDay lResult = {(int8_t)mTimeHelper.tm_mday, (int8_t)(mTimeHelper.tm_mon + 1)};
-    return lResult;
+uint8_t TimerModule::isHoliday(uint8_t iDay, uint8_t iMonth)
+{
+    if (iMonth < 1 || iMonth > 12 || iDay < 1 || iDay > TimerCalendar::daysInMonth(getYear(), iMonth))
+        return 0;
+    return getHolidayAt(TimerCalendar::dayOfYear(getYear(), iMonth, iDay));
 }
 
-/***************************************************************************/
-/* Note: year,month,date = calendar date, 1801-2099 only.             */
-/*       Eastern longitude positive, Western longitude negative       */
-/*       Northern latitude positive, Southern latitude negative       */
-/*       The longitude value IS critical in this function!            */
-/*       altit = the altitude which the Sun should cross              */
-/*               Set to -35/60 degrees for rise/set, -6 degrees       */
-/*               for civil, -12 degrees for nautical and -18          */
-/*               degrees for astronomical twilight.                   */
-/*         upper_limb: non-zero -> upper limb, zero -> center         */
-/*               Set to non-zero (e.g. 1) when computing rise/set     */
-/*               times, and to zero when computing start/end of       */
-/*               twilight.                                            */
-/*        *rise = where to store the rise time                        */
-/*        *set  = where to store the set  time                        */
-/*                Both times are relative to the specified altitude,  */
-/*                and thus this function can be used to compute       */
-/*                various twilight times, as well as rise/set times   */
-/* Return value:  0 = sun rises/sets this day, times stored at        */
-/*                    *trise and *tset.                               */
-/*               +1 = sun above the specified "horizon" 24 hours.     */
-/*                    *trise set to time when the sun is at south,    */
-/*                    minus 12 hours while *tset is set to the south  */
-/*                    time plus 12 hours. "Day" length = 24 hours     */
-/*               -1 = sun is below the specified "horizon" 24 hours   */
-/*                    "Day" length = 0 hours, *trise and *tset are    */
-/*                    both set to the time when the sun is at south.  */
-/*                                                                    */
-/**********************************************************************/
-int TimerModule::sunRiseSet(int year, int month, int day, double lon, double lat,
-                      double altit, int upper_limb, double *trise, double *tset)
-{
-    double d,    /* Days since 2000 Jan 0.0 (negative before) */
-        sr,      /* Solar distance, astronomical units */
-        sRA,     /* Sun's Right Ascension */
-        sdec,    /* Sun's declination */
-        sradius, /* Sun's apparent radius */
-        t,       /* Diurnal arc */
-        tsouth,  /* Time when Sun is at south */
-        sidtime; /* Local sidereal time */
-
-    int rc = 0; /* Return cde from function - usually 0 */
-
-    /* Compute d of 12h local mean solar time */
-    d = days_since_2000_Jan_0(year, month, day) + 0.5 - lon / 360.0;
-
-    /* Compute the local sidereal time of this moment */
-    sidtime = revolution(GMST0(d) + 180.0 + lon);
-
-    /* Compute Sun's RA, Decl and distance at this moment */
-    sunRadDec(d, &sRA, &sdec, &sr);
-
-    /* Compute time when Sun is at south - in hours UT */
-    tsouth = 12.0 - rev180(sidtime - sRA) / 15.0;
-
-    /* Compute the Sun's apparent radius in degrees */
-    sradius = 0.2666 / sr;
-
-    /* Do correction to upper limb, if necessary */
-    if (upper_limb)
-        altit -= sradius;
-
-    /* Compute the diurnal arc that the Sun traverses to reach */
-    /* the specified altitude altit: */
-    {
-        double cost;
-        cost = (sind(altit) - sind(lat) * sind(sdec)) /
-               (cosd(lat) * cosd(sdec));
-        if (cost >= 1.0)
-            rc = -1, t = 0.0; /* Sun always below altit */
-        else if (cost <= -1.0)
-            rc = +1, t = 12.0; /* Sun always above altit */
-        else
-            t = acosd(cost) / 15.0; /* The diurnal arc, hours */
+int16_t TimerModule::daysUntilNextHoliday()
+{
+    if (mHolidayMap.year != getYear())
+        return -1;
+    uint16_t lToday = mNow.yearDay;
+    uint16_t lDaysInYear = TimerCalendar::daysInYear(getYear());
+    // find first set bit from today up to end of year
+    uint8_t lWord = lToday >> 5;
+    uint32_t lBits = mHolidayMap.bits[lWord] & ~((1UL << (lToday & 31)) - 1);
+    while (true)
+    {
+        if (lBits)
+            return (lWord << 5) + __builtin_ctz(lBits) - lToday;
+        if (++lWord >= 12)
+            break;
+        lBits = mHolidayMap.bits[lWord];
+    }
+    // wrap around to next year, its easter and advent based holidays are on other days
+    sDay lEaster, lAdvent;
+    sHolidayMap lNextYear;
+    calculateEaster(getYear() + 1, &lEaster);
+    calculateAdvent(getYear() + 1, &lAdvent);
+    calculateHolidayMap(getYear() + 1, lEaster, lAdvent, mHolidayMask, &lNextYear);
+    for (lWord = 0; lWord < 12; lWord++)
+    {
+        if (lNextYear.bits[lWord])
+            return lDaysInYear - lToday + (lWord << 5) + __builtin_ctz(lNextYear.bits[lWord]);
+    }
+    return -1;
+}
+
+void TimerModule::calculateHolidays(bool iDebugOutput)
+{
+    TIMER_STAT(TIMER_STAT_HOLIDAYS);
+    // we check only if date is valid
+    if (mTimeValid < tmDateValid)
+        return;
+    // check if today or tomorrow is a holiday
+    uint16_t lToday = mNow.yearDay;
+    uint16_t lTomorrow = (lToday + 1 < TimerCalendar::daysInYear(getYear())) ? lToday + 1 : 0;
+    uint8_t lHolidayToday = getHolidayAt(lToday);
+    uint8_t lHolidayTomorrow = getHolidayAt(lTomorrow);
+    if (iDebugOutput)
+    {
+        for (uint16_t lDay = 0; lDay < 366; lDay++)
+        {
+            if (mHolidayMap.bits[lDay >> 5] & (1UL << (lDay & 31)))
+            {
+                int16_t lYear;
+                uint8_t lMonth, lDayOfMonth;
+                TimerCalendar::civilFromDays(TimerCalendar::daysFromCivil(getYear(), 1, 1) + lDay, lYear, lMonth, lDayOfMonth);
+                logInfo("LogicTimer", "%02d.%02d., ", lDayOfMonth, lMonth);
+            }
+        }
+    }
+    setHolidays(lHolidayToday, lHolidayTomorrow);
+}
+
+void TimerModule::setHolidays(uint8_t iToday, uint8_t iTomorrow)
+{
+    if (iToday != mHolidayToday || iTomorrow != mHolidayTomorrow)
+    {
+        mHolidayToday = iToday;
+        mHolidayTomorrow = iTomorrow;
+        mHolidayChanged = true;
+        mPendingChanges |= TIMER_CHANGE_HOLIDAY;
+        mSnapshotDirty = true;
     }
+}
+
+// starts the recalculation of the date dependant values for the current day,
+// the values of the year are kept if the year did not change
+void TimerModule::startRecalc(bool iDayChange)
+{
+#ifdef TIMER_DUALCORE
+    // results of older requests are ignored
+    mRecalcSerial++;
+#endif
+    mRecalc.dayNumber = mDayNumber;
+    mRecalc.step = (mRecalc.holidays.year == getYear()) ? TIMER_RECALC_HOLIDAYS : TIMER_RECALC_YEAR;
+    mRecalc.dayChange = mRecalc.dayChange || iDayChange;
+}
 
-    /* Store rise and set times - in hours UT */
-    *trise = tsouth - t;
-    *tset = tsouth + t;
+// year step of the recalculation: easter, advent and holiday map
+void TimerModule::recalcYear(sRecalc &ioRecalc, uint32_t iHolidayMask)
+{
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(ioRecalc.dayNumber, lYear, lMonth, lDay);
+    calculateEaster(lYear, &ioRecalc.easter);
+    calculateAdvent(lYear, &ioRecalc.advent);
+    calculateHolidayMap(lYear, ioRecalc.easter, ioRecalc.advent, iHolidayMask, &ioRecalc.holidays);
+    ioRecalc.step = TIMER_RECALC_HOLIDAYS;
+}
 
+// holiday step of the recalculation: holidays today and tomorrow
+void TimerModule::recalcHolidays(sRecalc &ioRecalc)
+{
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(ioRecalc.dayNumber, lYear, lMonth, lDay);
+    uint16_t lToday = TimerCalendar::dayOfYear(lYear, lMonth, lDay);
+    ioRecalc.holidayToday = getHolidayAt(ioRecalc.holidays, lToday);
+    ioRecalc.holidayTomorrow = getHolidayAt(ioRecalc.holidays, (lToday + 1 < TimerCalendar::daysInYear(lYear)) ? lToday + 1 : 0);
+    ioRecalc.step = TIMER_RECALC_SUN;
+}
+
+// continues the recalculation until it is complete or iBudget µs are used up
+void TimerModule::processRecalc(uint32_t iBudget)
+{
+#ifdef TIMER_DUALCORE
+    // core 1 calculates, unless the result is needed at once
+    if (iBudget != UINT32_MAX && mRecalc.step != TIMER_RECALC_PUBLISH)
+    {
+        if (mRecalc.serial != mRecalcSerial)
+        {
+            mRecalc.serial = mRecalcSerial;
+            mRecalcRequest.write({mRecalcSerial, mRecalc.dayNumber, mHolidayMask, mLongitude, mLatitude});
+            return;
+        }
+        sRecalc lResult;
+        if (!mRecalcResult.tryRead(&lResult) || lResult.serial != mRecalcSerial)
+            return;
+        lResult.dayChange = mRecalc.dayChange;
+        mRecalc = lResult;
+    }
+#endif
+    uint32_t lStart = TIMER_MICROS();
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(mRecalc.dayNumber, lYear, lMonth, lDay);
+    do
+    {
+        switch (mRecalc.step)
+        {
+            case TIMER_RECALC_YEAR:
+            {
+                TIMER_STAT(TIMER_STAT_YEAR);
+                recalcYear(mRecalc, mHolidayMask);
+                break;
+            }
+            case TIMER_RECALC_HOLIDAYS:
+            {
+                TIMER_STAT(TIMER_STAT_HOLIDAYS);
+                recalcHolidays(mRecalc);
+                break;
+            }
+            case TIMER_RECALC_SUN:
+            {
+                TIMER_STAT(TIMER_STAT_DAY);
+                calculateSunriseSunset(lYear, lMonth, lDay, &mRecalc.sunrise, &mRecalc.sunset);
+                mRecalc.step = TIMER_RECALC_PUBLISH;
+                break;
+            }
+            default:
+            {
+                // all results become visible within the same loop() call
+                mEaster = mRecalc.easter;
+                mAdvent = mRecalc.advent;
+                mHolidayMap = mRecalc.holidays;
+                setHolidays(mRecalc.holidayToday, mRecalc.holidayTomorrow);
+                convertToLocalTime(mRecalc.sunrise, &mSunrise);
+                convertToLocalTime(mRecalc.sunset, &mSunset);
+                mSnapshotDirty = true;
+#if TIMER_MAX_RULES > 0
+                mRulesDirty = true;
+#endif
+                if (mRecalc.dayChange)
+                    mPendingChanges |= TIMER_CHANGE_DAY;
+                mRecalc.dayChange = false;
+                mRecalc.step = TIMER_RECALC_IDLE;
+                break;
+            }
+        }
+    } while (mRecalc.step != TIMER_RECALC_IDLE && TIMER_MICROS() - lStart < iBudget);
+}
+
+#ifdef TIMER_SUN_FIXED
+typedef SunEngineFixed sun_engine_t;
+#else
+    #ifdef TIMER_SUN_FLOAT
+    typedef float sun_t;
+    #else
+    typedef double sun_t;
+    #endif
+typedef SunEngine<sun_t> sun_engine_t;
+#endif
+
+// sunrise/sunset in UT minutes of day, calculated with the selected sun engine
+int TimerModule::sunRiseSet(int year, int month, int day, float lon, float lat,
+                            float altit, int upper_limb, int16_t *trise, int16_t *tset)
+{
+    sSunDay lDay;
+    sunDay(year, month, day, lon, &lDay);
+    return sunRiseSet(lDay, lat, altit, upper_limb, trise, tset);
+}
+
+// altitude independent sun terms of a day
+void TimerModule::sunDay(int year, int month, int day, float lon, sSunDay *eDay)
+{
+    sun_engine_t::sunDay(year, month, day, lon, eDay);
+}
+
+// sunrise/sunset of the given sun terms in UT minutes of day, without any state of the module
+static int sunRiseSetMinutes(const sSunDay &iDay, float lat, float altit, int upper_limb, int16_t *trise, int16_t *tset)
+{
+#ifdef TIMER_SUN_FIXED
+    return SunEngineFixed::sunRiseSet(iDay, lat, altit, upper_limb, trise, tset);
+#else
+    sun_t rise, set;
+    int rc = SunEngine<sun_t>::sunRiseSet(iDay, lat, altit, upper_limb, &rise, &set);
+    *trise = (int16_t)std::floor(rise * sun_t(60.0));
+    *tset = (int16_t)std::floor(set * sun_t(60.0));
     return rc;
+#endif
+}
+
+int TimerModule::sunRiseSet(const sSunDay &iDay, float lat, float altit, int upper_limb, int16_t *trise, int16_t *tset)
+{
+    TIMER_STAT(TIMER_STAT_SUN);
+    return sunRiseSetMinutes(iDay, lat, altit, upper_limb, trise, tset);
+}
+
+#ifdef TIMER_DUALCORE
+// runs on core 1: calculates the latest requested recalculation and hands the result back to core 0
+void TimerModule::loop1()
+{
+    sRecalcRequest lRequest;
+    if (!mRecalcRequest.tryRead(&lRequest) || lRequest.serial == mRecalcCore1.serial)
+        return;
+    sRecalc &lRecalc = mRecalcCore1;
+    lRecalc.serial = lRequest.serial;
+    lRecalc.dayNumber = lRequest.dayNumber;
+    recalcYear(lRecalc, lRequest.holidayMask);
+    recalcHolidays(lRecalc);
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(lRecalc.dayNumber, lYear, lMonth, lDay);
+    sSunDay lSunDay;
+    sunDay(lYear, lMonth, lDay, lRequest.longitude, &lSunDay);
+    sunRiseSetMinutes(lSunDay, lRequest.latitude, -35.0f / 60.0f, 1, &lRecalc.sunrise, &lRecalc.sunset);
+    lRecalc.step = TIMER_RECALC_PUBLISH;
+    mRecalcResult.write(lRecalc);
 }
+#endif
 
-/******************************************************/
-/* Computes the Sun's ecliptic longitude and distance */
-/* at an instant given in d, number of days since     */
-/* 2000 Jan 0.0.  The Sun's ecliptic latitude is not  */
-/* computed, since it's always very near 0.           */
-/******************************************************/
-void TimerModule::sunPos(double d, double *lon, double *r)
-{
-    double M, /* Mean anomaly of the Sun */
-        w,    /* Mean longitude of perihelion */
-              /* Note: Sun's mean longitude = M + w */
-        e,    /* Eccentricity of Earth's orbit */
-        E,    /* Eccentric anomaly */
-        x, y, /* x, y coordinates in orbit */
-        v;    /* True anomaly */
-
-    /* Compute mean elements */
-    M = revolution(356.0470 + 0.9856002585 * d);
-    w = 282.9404 + 4.70935E-5 * d;
-    e = 0.016709 - 1.151E-9 * d;
-
-    /* Compute true longitude and radius vector */
-    E = M + e * RADEG * sind(M) * (1.0 + e * cosd(M));
-    x = cosd(E) - e;
-    y = sqrt(1.0 - e * e) * sind(E);
-    *r = sqrt(x * x + y * y); /* Solar distance */
-    v = atan2d(y, x);         /* True anomaly */
-    *lon = v + w;             /* True solar longitude */
-    if (*lon >= 360.0)
-        *lon -= 360.0; /* Make it 0..360 degrees */
-}
-
-/******************************************************/
-/* Computes the Sun's equatorial coordinates RA, Decl */
-/* and also its distance, at an instant given in d,   */
-/* the number of days since 2000 Jan 0.0.             */
-/******************************************************/
-void TimerModule::sunRadDec(double d, double *RA, double *dec, double *r)
-{
-    double lon, obl_ecl, x, y, z;
-
-    /* Compute Sun's ecliptical coordinates */
-    sunPos(d, &lon, r);
-
-    /* Compute ecliptic rectangular coordinates (z=0) */
-    x = *r * cosd(lon);
-    y = *r * sind(lon);
-
-    /* Compute obliquity of ecliptic (inclination of Earth's axis) */
-    obl_ecl = 23.4393 - 3.563E-7 * d;
-
-    /* Convert to equatorial rectangular coordinates - x is unchanged */
-    z = y * sind(obl_ecl);
-    y = y * cosd(obl_ecl);
-
-    /* Convert to spherical coordinates */
-    *RA = atan2d(y, x);
-    *dec = atan2d(z, sqrt(x * x + y * y));
-
-}
-
-/******************************************************************/
-/* This function reduces any angle to within the first revolution */
-/* by subtracting or adding even multiples of 360.0 until the     */
-/* result is >= 0.0 and < 360.0                                   */
-/******************************************************************/
-
-#define INV360 (1.0 / 360.0)
-
-/*****************************************/
-/* Reduce angle to within 0..360 degrees */
-/*****************************************/
-double TimerModule::revolution(double x)
-{
-    return (x - 360.0 * floor(x * INV360));
-}
-
-/*********************************************/
-/* Reduce angle to within +180..+180 degrees */
-/*********************************************/
-double TimerModule::rev180(double x)
-{
-    return (x - 360.0 * floor(x * INV360 + 0.5));
-}
-
-/*******************************************************************/
-/* This function computes GMST0, the Greenwich Mean Sidereal Time  */
-/* at 0h UT (i.e. the sidereal time at the Greenwhich meridian at  */
-/* 0h UT).  GMST is then the sidereal time at Greenwich at any     */
-/* time of the day.  I've generalized GMST0 as well, and define it */
-/* as:  GMST0 = GMST - UT  --  this allows GMST0 to be computed at */
-/* other times than 0h UT as well.  While this sounds somewhat     */
-/* contradictory, it is very practical:  instead of computing      */
-/* GMST like:                                                      */
-/*                                                                 */
-/*  GMST = (GMST0) + UT * (366.2422/365.2422)                      */
-/*                                                                 */
-/* where (GMST0) is the GMST last time UT was 0 hours, one simply  */
-/* computes:                                                       */
-/*                                                                 */
-/*  GMST = GMST0 + UT                                              */
-/*                                                                 */
-/* where GMST0 is the GMST "at 0h UT" but at the current moment!   */
-/* Defined in this way, GMST0 will increase with about 4 min a     */
-/* day.  It also happens that GMST0 (in degrees, 1 hr = 15 degr)   */
-/* is equal to the Sun's mean longitude plus/minus 180 degrees!    */
-/* (if we neglect aberration, which amounts to 20 seconds of arc   */
-/* or 1.33 seconds of time)                                        */
-/*                                                                 */
-/*******************************************************************/
-
-double TimerModule::GMST0(double d)
-{
-    double sidtim0;
-    /* Sidtime at 0h UT = L (Sun's mean longitude) + 180.0 degr  */
-    /* L = M + w, as defined in sunpos().  Since I'm too lazy to */
-    /* add these numbers, I'll let the C compiler do it for me.  */
-    /* Any decent C compiler will add the constants at compile   */
-    /* time, imposing no runtime or code overhead.               */
-    sidtim0 = revolution((180.0 + 356.0470 + 282.9404) +
-                         (0.9856002585 + 4.70935E-5) * d);
-    return sidtim0;
-} /* GMST0 */
+// time of the sun at south in UT minutes of day
+int16_t TimerModule::sunNoon(const sSunDay &iDay)
+{
+#ifdef TIMER_SUN_FIXED
+    return (int16_t)((iDay.tsouth * 1440) >> 32);
+#else
+    return (int16_t)std::floor(iDay.tsouth * sun_t(60.0));
+#endif
+}
 
 TimerModule openknxTimerModule;
\ No newline at end of file
@@ -10,15 +10,162 @@
 #include <math.h>
 #include <ctime>
 #include "OpenKNX.h"
+#include "TimerCalendar.h"
+#include "SunEngine.h"
+#include "TimerSeqLock.h"
 
 #define MINYEAR 2022
+#define TIMER_TABLE_MAXYEAR 2099 // last year of the precalculated easter/advent table
+
+// time base of the timer, all millisecond timestamps are taken from here.
+// Define TIMER_MILLIS before including this file to inject an other
+// clock (i.e. for host builds or benchmarks)
+#ifndef TIMER_MILLIS
+    #define TIMER_MILLIS() millis()
+#endif
+#ifndef TIMER_MICROS
+    #define TIMER_MICROS() micros()
+#endif
+
+// clock discipline against bus time telegrams
+#define TIMER_STEP_LIMIT 3000                   // ms, larger offsets to bus time are stepped instead of slewed
+#define TIMER_SLEW_RATE 5                       // ms per second an offset is slewed with (0.5%)
+#define TIMER_COALESCE_WINDOW 500               // ms a date telegram waits for the time telegram and vice versa
+#define TIMER_MIDNIGHT_WINDOW 10                // s around midnight, in which a date telegram may belong to the other day
+#define TIMER_DRIFT_MIN_INTERVAL 43200000LL     // ms (12 hours) of bus time needed for a drift estimate
+#define TIMER_DRIFT_MIN_SAMPLES 8               // time telegrams needed for a drift estimate, bus time has a resolution of 1 s
+#define TIMER_DRIFT_MAX_INTERVAL 3456000000LL   // ms (40 days), a new measurement is started before millis() wraps
+#define TIMER_DRIFT_LIMIT 500000LL              // ppb, larger drift is considered as a jump of the bus time
+
+// clock state saved with writeFlash(): version, flags, local epoch, drift
+#define TIMER_FLASH_VERSION 1
+#define TIMER_FLASH_SIZE 10
+
+// time sources, a lower priority value is preferred, then a lower stratum
+#ifndef TIMER_MAX_SOURCES
+    #define TIMER_MAX_SOURCES 4
+#endif
+#define TIMER_SOURCE_BUS 0                      // built in source for time telegrams
+#define TIMER_PRIORITY_BUS 100
+#define TIMER_SOURCE_TIMEOUT 7200000            // ms, a source without time for this long loses its master role
+#define TIMER_SOURCE_POLL 60000                 // ms between polls of sources with a poll callback
+#define TIMER_OUTLIER_LIMIT 60000LL             // ms, larger jumps have to be confirmed by the next time of the source
+#define TIMER_SLEW_DEADBAND 50                  // ms, smaller offsets are left to the drift correction
+
+// parts of a date/time update from the bus
+#define TIMER_BUS_DATE 0x01
+#define TIMER_BUS_TIME 0x02
+
+// minutes missed by a starved loop, which are replayed one by one, older ones are coalesced (0 = coalesce all)
+#ifndef TIMER_CATCHUP_REPLAY
+#define TIMER_CATCHUP_REPLAY 0
+#endif
+
+// the date dependant values (holidays, sunrise/sunset) are recalculated step by step over several
+// loop() calls, each call continues for at most TIMER_RECALC_BUDGET µs (but does at least one step)
+#ifndef TIMER_RECALC_BUDGET
+    #define TIMER_RECALC_BUDGET 1000
+#endif
+#define TIMER_RECALC_IDLE 0
+#define TIMER_RECALC_YEAR 1     // easter, advent and holiday map of the year
+#define TIMER_RECALC_HOLIDAYS 2 // holidays today and tomorrow
+#define TIMER_RECALC_SUN 3      // sunrise and sunset
+#define TIMER_RECALC_PUBLISH 4  // all results at once
+
+// Define TIMER_DUALCORE on dual core devices (OPENKNX_DUALCORE) to do the recalculation on core 1,
+// core 0 just publishes the result then
+#if defined(TIMER_DUALCORE) && !defined(OPENKNX_DUALCORE)
+    #error "TIMER_DUALCORE needs OPENKNX_DUALCORE"
+#endif
+
+// runtime statistics of the hot paths, readable with the console command "timer stats".
+// Define TIMER_STATS to compile them in, otherwise they cost nothing.
+#ifdef TIMER_STATS
+    #define TIMER_STAT(stat) TimerStatScope lStatScope(mStats[stat])
+    #define TIMER_COUNT(counter) mCounters[counter]++
+#else
+    #define TIMER_STAT(stat)
+    #define TIMER_COUNT(counter)
+#endif
+#define TIMER_STAT_LOOP 0
+#define TIMER_STAT_YEAR 1       // year step of the recalculation
+#define TIMER_STAT_DAY 2        // sun step of the recalculation
+#define TIMER_STAT_HOLIDAYS 3   // holiday step of the recalculation, calculateHolidays()
+#define TIMER_STAT_SUN 4        // sunRiseSet()
+#define TIMER_STAT_INPUT 5      // processInputKo()
+#define TIMER_STAT_COUNT 6
+#define TIMER_COUNT_SYNC 0      // times applied from a time source
+#define TIMER_COUNT_STEP 1      // clock steps
+#define TIMER_COUNT_SLEW 2      // offsets slewed
+#define TIMER_COUNT_COUNT 3
 
 #define SUN_SUNRISE 0x00
 #define SUN_SUNSET 0x01
 
-#define REMOVED 0
-#define EASTER -1
-#define ADVENT -2
+// number of altitudes getSunDegree() remembers for the current day
+#ifndef TIMER_SUN_CACHE_SIZE
+    #define TIMER_SUN_CACHE_SIZE 8
+#endif
+
+// number of events, which can be registered with addTimeEvent()/addSunEvent()
+#ifndef TIMER_MAX_EVENTS
+    #define TIMER_MAX_EVENTS 32
+#endif
+
+// events skipped by a forward step of the clock up to this number of minutes are fired late,
+// a backward step up to this number of minutes does not fire them again (covers the summertime hour)
+#ifndef TIMER_EVENT_CATCHUP
+    #define TIMER_EVENT_CATCHUP 120
+#endif
+
+// number of rules, which can be registered with addTimeRule()/addSunRule() (0 = no rule engine).
+// Rules are compiled once a day into a sorted list of fire minutes, the rules due in the
+// current minute are provided as bitset for polling consumers like logic channels.
+#ifndef TIMER_MAX_RULES
+    #define TIMER_MAX_RULES 0
+#endif
+#define TIMER_RULE_WORDS ((TIMER_MAX_RULES + 31) / 32)
+
+// number of listeners, which can be registered with addChangeListener()
+#ifndef TIMER_MAX_LISTENERS
+    #define TIMER_MAX_LISTENERS 8
+#endif
+
+// Define TIMER_SUN_TABLE to precalculate sunrise/sunset for each day of the
+// current year (about 1.5 kB RAM). The table is filled one day per idle loop.
+
+// holiday rules, 2 bit type and 14 bit data
+#define TIMER_HOLIDAY_COUNT 32
+#define HOLIDAY_TYPE_MASK 0xC000
+#define HOLIDAY_TYPE_FIXED 0x0000
+#define HOLIDAY_TYPE_EASTER 0x4000
+#define HOLIDAY_TYPE_ADVENT 0x8000
+#define HOLIDAY_TYPE_WEEKDAY_BEFORE 0xC000
+#define HOLIDAY_FIXED(day, month) (uint16_t)(HOLIDAY_TYPE_FIXED | (month) << 5 | (day))
+#define HOLIDAY_EASTER(offset) (uint16_t)(HOLIDAY_TYPE_EASTER | ((offset) & 0x1FF))  // days relative to easter sunday
+#define HOLIDAY_ADVENT(offset) (uint16_t)(HOLIDAY_TYPE_ADVENT | ((offset) & 0x1FF))  // days relative to fourth advent
+#define HOLIDAY_WEEKDAY_BEFORE(weekday, day, month) (uint16_t)(HOLIDAY_TYPE_WEEKDAY_BEFORE | (weekday) << 9 | (month) << 5 | (day))
+
+// holiday presets for setHolidayRegion()
+#define TIMER_REGION_DE 0
+#define TIMER_REGION_DE_BW 1
+#define TIMER_REGION_DE_BY 2
+#define TIMER_REGION_DE_BE 3
+#define TIMER_REGION_DE_BB 4
+#define TIMER_REGION_DE_HB 5
+#define TIMER_REGION_DE_HH 6
+#define TIMER_REGION_DE_HE 7
+#define TIMER_REGION_DE_MV 8
+#define TIMER_REGION_DE_NI 9
+#define TIMER_REGION_DE_NW 10
+#define TIMER_REGION_DE_RP 11
+#define TIMER_REGION_DE_SL 12
+#define TIMER_REGION_DE_SN 13
+#define TIMER_REGION_DE_ST 14
+#define TIMER_REGION_DE_SH 15
+#define TIMER_REGION_DE_TH 16
+#define TIMER_REGION_AT 17
+#define TIMER_REGION_COUNT 18
 
 // DPT19 special flags
 #define DPT19_FAULT 0x80
@@ -30,6 +177,33 @@
 #define DPT19_NO_TIME 0x02
 #define DPT19_SUMMERTIME 0x01
 
+// Types of registered events
+#define TIMER_EVENT_TIME 0    // fixed local time
+#define TIMER_EVENT_SUNRISE 1 // offset to sunrise
+#define TIMER_EVENT_SUNSET 2  // offset to sunset
+
+// Weekday masks for registered events, bit 0 is sunday (like tm_wday)
+#define TIMER_WEEKDAYS_ALL 0x7F
+#define TIMER_WEEKDAYS_WORK 0x3E
+#define TIMER_WEEKDAYS_WEEKEND 0x41
+
+// Month masks for rules, bit 0 is january
+#define TIMER_MONTHS_ALL 0x0FFF
+
+// Holiday handling of rules
+#define TIMER_RULE_HOLIDAY_IGNORE 0 // holidays are normal days
+#define TIMER_RULE_HOLIDAY_SKIP 1   // not on holidays
+#define TIMER_RULE_HOLIDAY_ONLY 2   // only on holidays, regardless of the weekday
+#define TIMER_RULE_HOLIDAY_SUNDAY 3 // holidays are treated like sunday
+
+// Change notifications for listeners, combined as bitmask
+#define TIMER_CHANGE_MINUTE 0x01
+#define TIMER_CHANGE_HOUR 0x02
+#define TIMER_CHANGE_DAY 0x04
+#define TIMER_CHANGE_HOLIDAY 0x08
+#define TIMER_CHANGE_SUMMERTIME 0x10
+#define TIMER_CHANGE_RULES 0x20     // rules are due in this minute
+
 // Values for Summertime
 #define VAL_STIM_FROM_KO 0
 #define VAL_STIM_FROM_DPT19 1
@@ -47,6 +221,177 @@ struct sDay
     int8_t month;
 };
 
+// broken down local time, carried along with the epoch seconds of the clock
+struct sDateTime
+{
+    uint16_t year;
+    uint16_t yearDay; // 0..365
+    uint8_t month;    // 1..12
+    uint8_t day;      // 1..31
+    uint8_t weekday;  // 0 = sunday
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+};
+
+struct sSunCacheEntry
+{
+    float degree;
+    bool upperLimb;
+    int16_t rise; // UT minutes of day
+    int16_t set;
+    int8_t rc;    // +1 sun always above, -1 always below the altitude
+};
+
+// altitude for getSunTimes()
+struct sSunAltitude
+{
+    float degree;   // -35/60 for sunrise/sunset, -6 civil, -12 nautical, -18 astronomical twilight
+    bool upperLimb; // true for sunrise/sunset
+};
+
+#ifdef TIMER_SUN_FIXED
+typedef SunEngineFixed::Day sSunDay;
+#elif defined(TIMER_SUN_FLOAT)
+typedef SunEngine<float>::Day sSunDay;
+#else
+typedef SunEngine<double>::Day sSunDay;
+#endif
+
+// slowly changing sun terms of a UT day, RA and declination are interpolated over the day
+struct sSunPositionDay
+{
+    int32_t day;   // day number the terms are valid for
+    float gmst0;   // GMST0 at 0h UT in degrees
+    float ra[2];   // right ascension at 0h UT of this and the next day in degrees
+    float dec[2];  // declination at 0h UT of this and the next day in degrees
+};
+
+typedef void (*TimerEventCallback)(uint8_t iEventId, void *iContext);
+
+typedef void (*TimerChangeCallback)(uint8_t iChanges, void *iContext);
+
+struct sTimerListener
+{
+    TimerChangeCallback callback; // nullptr for unused entries
+    void *context;
+    uint8_t changes; // mask of TIMER_CHANGE_* the listener is interested in
+};
+
+struct sTimerEvent
+{
+    TimerEventCallback callback; // nullptr for unused entries
+    void *context;
+    uint32_t nextFire; // local minutes since 1970-01-01
+    int16_t minute;    // minute of day for time events, offset in minutes for sun events
+    uint8_t type;
+    uint8_t weekdays;
+};
+
+// a summertime transition like in POSIX TZ "Mm.w.d/time"
+struct sDstRule
+{
+    uint8_t month;   // 1..12
+    uint8_t week;    // 1..4, 5 = last
+    uint8_t weekday; // 0 = sunday
+    int16_t minute;  // local minute of day, at which the transition happens (wall clock before switching)
+};
+
+struct sTimezoneRule
+{
+    int16_t offset;    // standard time offset to UT in minutes (east positive)
+    int16_t dstOffset; // additional offset during summertime in minutes, 0 if there is no summertime
+    sDstRule start;    // begin of summertime in local standard time
+    sDstRule end;      // end of summertime in local summertime
+};
+
+// returns the current time of a polled time source in UTC seconds since 1970, false if there is none
+typedef bool (*TimerSourceCallback)(uint32_t *eUtcEpoch, void *iContext);
+
+struct sTimerSource
+{
+    TimerSourceCallback poll; // optional, called every TIMER_SOURCE_POLL ms
+    void *context;
+    uint32_t lastUpdate;      // millis() of the last time of this source
+    int64_t jumpOffset;       // offset of a jump waiting for confirmation
+    uint8_t priority;
+    uint8_t stratum;          // quality of the source (1 = reference clock)
+    bool jumpPending;
+    bool used;
+};
+
+#ifdef TIMER_STATS
+struct sTimerStat
+{
+    uint32_t count;
+    uint32_t last; // µs
+    uint32_t max;  // µs
+    uint64_t total; // µs
+};
+
+// measures the runtime of the enclosing block
+class TimerStatScope
+{
+    sTimerStat &mStat;
+    uint32_t mStart;
+
+  public:
+    TimerStatScope(sTimerStat &iStat) : mStat(iStat), mStart(TIMER_MICROS()) {}
+    ~TimerStatScope()
+    {
+        uint32_t lDuration = TIMER_MICROS() - mStart;
+        mStat.count++;
+        mStat.last = lDuration;
+        mStat.total += lDuration;
+        if (lDuration > mStat.max)
+            mStat.max = lDuration;
+    }
+};
+#endif
+
+struct sHolidayMap
+{
+    int16_t year;                     // year the map is calculated for
+    uint32_t bits[12];                // one bit per (0 based) day of year, set if this day is a holiday
+    uint8_t ids[TIMER_HOLIDAY_COUNT]; // holiday number for each set bit, ordered by day of year
+};
+
+// date dependant values under recalculation, they are published together when complete
+struct sRecalc
+{
+    int32_t dayNumber;
+    sDay easter;
+    sDay advent;
+    sHolidayMap holidays;
+    uint8_t holidayToday;
+    uint8_t holidayTomorrow;
+    int16_t sunrise; // UT minutes of day
+    int16_t sunset;
+    uint8_t step;     // TIMER_RECALC_*
+    bool dayChange;  // publishing signals TIMER_CHANGE_DAY
+    uint32_t serial; // request the result belongs to (TIMER_DUALCORE)
+};
+
+// recalculation request from core 0 to core 1
+struct sRecalcRequest
+{
+    uint32_t serial;
+    int32_t dayNumber;
+    uint32_t holidayMask;
+    float longitude;
+    float latitude;
+};
+
+// date and time telegrams collected to one update
+struct sBusTime
+{
+    int32_t dayNumber;   // days since 1970-01-01
+    int32_t second;      // second of day
+    uint32_t timeMillis; // millis() at reception of the time
+    uint32_t received;   // millis() at reception of the first telegram
+    uint8_t parts;       // TIMER_BUS_DATE | TIMER_BUS_TIME
+};
+
 enum eTimeValid
 {
     tmInvalid,
@@ -55,23 +400,60 @@ enum eTimeValid
     tmValid
 };
 
+struct sTimerRule
+{
+    int16_t minute;   // minute of day for time rules, offset in minutes for sun rules
+    int16_t earliest; // bounds of sun rules as minute of day, -1 for none
+    int16_t latest;
+    uint8_t type;     // TIMER_EVENT_*
+    bool used;
+};
+
+// consistent copy of the state of the timer for readers in other modules, ISRs or on core 1,
+// after midnight it shows the last second of the old day, until the new day is recalculated
+struct sTimerSnapshot
+{
+    sDateTime now;           // local time
+    uint32_t epoch;          // UTC seconds since 1970
+    int16_t utcOffset;       // minutes of local time to UTC
+    uint8_t valid;           // eTimeValid
+    bool summertime;
+    bool provisional;        // time is restored from flash and not yet confirmed
+    uint8_t holidayToday;
+    uint8_t holidayTomorrow;
+    sTime sunrise;           // local time
+    sTime sunset;
+};
+
 class TimerModule : public OpenKNX::Module
 {
   protected:
-    static const uint8_t cHolidaysCount = 32;
-    static sDay cHolidays[cHolidaysCount];
-    struct tm mTimeHelper;
+    uint32_t mHolidayMask = 0; // active holidays, holiday 1 is the most significant bit
     // double mLongitude;
     // double mLatitude;
     // int8_t mTimezone;
-    bool mUseSummertime;
-    bool mIsSummertime;
+    bool mUseSummertime = false;
+    bool mIsSummertime = false;
+    sTimezoneRule mTimezoneRule = {60, 60, {3, 5, 0, 120}, {10, 5, 0, 180}}; // CET-1CEST,M3.5.0,M10.5.0/3
+    int16_t mDstYear = -1;     // year of the transitions below
+    uint32_t mDstStart = 0;    // begin of summertime in local minutes since 1970-01-01
+    uint32_t mDstEnd = 0;      // end of summertime in local minutes since 1970-01-01
+    uint32_t mDstMinute = 0;   // local minute of the last summertime check of the running clock, 0 after the clock was set
+    bool mTimezoneSet = false; // rule set by setTimezone(), setup() keeps it
     eTimeValid mTimeValid = tmInvalid;
     uint32_t mTimeDelay = 0;
     bool mMinuteChanged = false;
     uint8_t mHolidayToday = 0;
     uint8_t mHolidayTomorrow = 0;
     bool mHolidayChanged = false;
+    sHolidayMap mHolidayMap = {-1, {}, {}};
+    sRecalc mRecalc = {};
+#ifdef TIMER_DUALCORE
+    TimerSeqLock<sRecalcRequest> mRecalcRequest; // written by core 0
+    TimerSeqLock<sRecalc> mRecalcResult;         // written by core 1
+    uint32_t mRecalcSerial = 0;                  // latest request of core 0
+    sRecalc mRecalcCore1 = {};                   // only used by core 1
+#endif
     sTime mSunrise;
     sTime mSunset;
     sDay mEaster = {0, 0}; // easter sunday
@@ -81,43 +463,169 @@ class TimerModule : public OpenKNX::Module
     int8_t mDayTick = -1;     // sunrise/sunset calculation happens each time the day changes
     int8_t mMonthTick = -1;   // sunrise/sunset calculation happens each time the month changes
     int16_t mYearTick = -1; // easter calculation happens each time year changes
+    uint32_t mEpoch = 0;      // local seconds since 1970-01-01, mNow is derived from it
+    int32_t mDayNumber = 0;   // days since 1970-01-01 of mNow, carried along with mNow
+    int32_t mDriftPpb = 0;            // learned drift of millis() against bus time in ppb (positive = millis() too fast)
+    int32_t mDriftAccu = 0;           // drift correction in ns not yet applied to mTimeDelay
+    int32_t mSlewRemaining = 0;       // offset to bus time in ms still to be slewed (positive = clock is behind)
+    int32_t mClockOffset = 0;         // offset to bus time in ms measured with the last time telegram
+    int64_t mDriftAnchorTime = -1;    // bus time in local ms since 1970 at the start of the drift measurement
+    uint32_t mDriftAnchorMillis = 0;  // millis() at the start of the drift measurement
+    uint32_t mDriftSamples = 0;       // time telegrams of the drift measurement, fitted by least squares:
+    double mDriftMeanX = 0;           // mean bus time in s since the anchor
+    double mDriftMeanY = 0;           // mean difference of millis() to bus time in ms since the anchor
+    double mDriftSumXX = 0;           // sum of squared deviations of the bus time
+    double mDriftSumXY = 0;           // sum of products of the deviations
+    sBusTime mBusPending = {};
+    bool mTimeProvisional = false;    // time is restored from flash and not yet confirmed by the bus
+    sTimerSource mSources[TIMER_MAX_SOURCES] = {};
+    int8_t mMasterSource = -1;        // source steering the clock
+    uint32_t mSourcePollTime = 0;
+    uint32_t mSourceRejects = 0;      // times rejected as outlier
+    uint32_t mSourceSwitches = 0;     // changes of the master source
+    TimerSeqLock<sTimerSnapshot> mSnapshot;
+    uint32_t mSnapshotEpoch = 0;      // mEpoch of the last snapshot
+    bool mSnapshotDirty = true;       // state other than the time changed since the last snapshot
+#ifdef TIMER_STATS
+    sTimerStat mStats[TIMER_STAT_COUNT] = {};
+    uint32_t mCounters[TIMER_COUNT_COUNT] = {};
+    void showStats();
+#endif
+    uint32_t mLagCount = 0;           // number of loop() calls, which had to catch up more than one second
+    uint32_t mLagMax = 0;             // maximum number of seconds loop() was behind
+    sSunCacheEntry mSunCache[TIMER_SUN_CACHE_SIZE];
+    uint8_t mSunCacheCount = 0;     // number of valid cache entries
+    uint8_t mSunCacheNext = 0;      // entry to be replaced next (round robin)
+    int32_t mSunCacheDay = -1;      // day number the cache is valid for
+    float mSunCacheLongitude = 0;   // location the cache is valid for
+    float mSunCacheLatitude = 0;
+    uint32_t mSunCacheHits = 0;
+    uint32_t mSunCacheMisses = 0;
+    sSunDay mSunCacheTerms;         // altitude independent terms of mSunCacheDay
+    sSunPositionDay mSunPositionDay = {-1, 0, {0, 0}, {0, 0}};
+    sTimerEvent mEvents[TIMER_MAX_EVENTS] = {};
+    uint8_t mEventHeap[TIMER_MAX_EVENTS]; // indexes into mEvents, min-heap ordered by nextFire
+    uint8_t mEventHeapSize = 0;
+    bool mEventsDirty = false;            // all fire times have to be recalculated
+    uint32_t mEventsMinute = 0;           // last local minute processed by processEvents()
+#if TIMER_MAX_RULES > 0
+    sTimerRule mRules[TIMER_MAX_RULES] = {};
+    uint32_t mRulesWeekday[7][TIMER_RULE_WORDS] = {}; // rules per weekday, one bit per rule
+    uint32_t mRulesMonth[12][TIMER_RULE_WORDS] = {};  // rules per month
+    uint32_t mRulesHoliday[4][TIMER_RULE_WORDS] = {}; // rules per TIMER_RULE_HOLIDAY_*
+    uint32_t mRulesDue[TIMER_RULE_WORDS] = {};        // rules due in the current minute
+    uint16_t mRuleFireMinute[TIMER_MAX_RULES];        // fire list of the day, sorted by minute of day
+    uint16_t mRuleFireId[TIMER_MAX_RULES];
+    uint16_t mRuleFireCount = 0;
+    uint16_t mRuleFireNext = 0;                       // next entry of the fire list
+    int32_t mRulesDay = -1;                           // day the fire list is compiled for
+    int16_t mRulesMinute = -1;                        // minute of day mRulesDue belongs to
+    bool mRulesDirty = true;                          // fire list has to be compiled again
+#endif
+    sTimerListener mListeners[TIMER_MAX_LISTENERS] = {};
+    uint8_t mPendingChanges = 0; // TIMER_CHANGE_* collected since the last notification
+#ifdef TIMER_SUN_TABLE
+    int16_t mSunTable[366][2];    // sunrise/sunset in UT minutes of day, indexed by day of year
+    int16_t mSunTableYear = -1;   // year the table is filled for
+    uint16_t mSunTableCount = 0;  // number of days already calculated
+    float mSunTableLongitude = 0; // location the table is calculated for
+    float mSunTableLatitude = 0;
+#endif
 
-    void calculateEaster();
-    void calculateAdvent();
+    void calculateEaster(int16_t iYear, sDay *eEaster);
+    void calculateAdvent(int16_t iYear, sDay *eAdvent);
     void calculateSummertime();
-    uint8_t calculateLastSundayInMonth(uint8_t iMonth);
+    void calculateDstTransitions(int16_t iYear, uint32_t *eStart, uint32_t *eEnd);
+    bool isSummertimeAt(uint32_t iLocalMinute, bool iCurrent = true);
+    int16_t getUtcOffset(int32_t iDayNumber, int16_t iUtMinute);
+    void calculateHolidayMap(int16_t iYear, const sDay &iEaster, const sDay &iAdvent, uint32_t iHolidayMask, sHolidayMap *eMap);
+    uint8_t getHolidayAt(const sHolidayMap &iMap, uint16_t iDayOfYear);
+    void setHolidays(uint8_t iToday, uint8_t iTomorrow);
+    void startRecalc(bool iDayChange);
+    void processRecalc(uint32_t iBudget);
+    void recalcYear(sRecalc &ioRecalc, uint32_t iHolidayMask);
+    void recalcHolidays(sRecalc &ioRecalc);
     void calculateHolidays(bool iDebugOutput = false);
+    uint8_t getHolidayAt(uint16_t iDayOfYear);
     void calculateSunriseSunset();
-    void convertToLocalTime(double iTime, sTime *eTime);
-    bool isEqualDate(sDay &iDate1, sDay &iDate2);
-    sDay getDayByOffset(int8_t iOffset, sDay &iDate);
+    int16_t toLocalMinutes(int16_t iMinutes);
+    int16_t toLocalMinutes(int16_t iMinutes, int32_t iDayNumber);
+    void convertToLocalTime(int16_t iMinutes, sTime *eTime);
+    void convertToLocalTime(int16_t iMinutes, int32_t iDayNumber, sTime *eTime);
+    void calculateSunriseSunset(int16_t iYear, uint8_t iMonth, uint8_t iDay, int16_t *eRise, int16_t *eSet);
+    sSunCacheEntry *getSunCacheEntry(float iDegree, bool iUpperLimb);
+    int8_t addEvent(uint8_t iType, int16_t iMinute, uint8_t iWeekdays, TimerEventCallback iCallback, void *iContext);
+    uint32_t calculateNextFire(sTimerEvent &iEvent, uint32_t iNow);
+    void rebuildEvents();
+    void pushEvent(uint8_t iEventId);
+    uint8_t popEvent();
+    bool isEventQueued(uint8_t iEventId);
+    void purgeEvents();
+    void processEvents();
+    bool isClockRunning();
+#if TIMER_MAX_RULES > 0
+    int16_t addRule(uint8_t iType, int16_t iMinute, int16_t iEarliest, int16_t iLatest, uint8_t iWeekdays, uint16_t iMonths, uint8_t iHolidays);
+    void compileRules();
+    void processRules();
+#endif
+    void notifyListeners();
+#ifdef TIMER_SUN_TABLE
+    void processSunTable();
+#endif
+    void tickSecond();
+    void setEpoch(uint32_t iEpoch);
+    void processTick();
+    void adjustTimeDelay(uint32_t iSeconds);
+    void advanceSeconds(uint32_t iSeconds);
+    uint32_t getMillisOfSecond();
+    void setDate(int32_t iDayNumber);
+    void learnDrift(int64_t iBusTime, uint32_t iMillis);
+    uint8_t decodeBusTime(uint8_t *iData, uint8_t iSize, uint8_t iParts, int32_t *eDayNumber, int32_t *eSecond);
+    void receiveBusTime(uint8_t iParts, int32_t iDayNumber, int32_t iSecond);
+    void flushBusTime();
+    void applyBusTime(uint8_t iParts, int32_t iDayNumber, int32_t iSecond, uint32_t iMillis);
+    int32_t resolveBusDay(uint8_t iParts, int32_t iDayNumber, int32_t iSecond);
+    int64_t offsetTo(int32_t iDayNumber, int32_t iSecond, uint32_t iMillis);
+    bool acceptTime(uint8_t iSourceId, uint8_t iParts, int32_t iDayNumber, int32_t iSecond, uint32_t iMillis);
+    bool isSummertimeJump(int64_t iOffset);
+    void pollTimeSources();
+    void updateSnapshot();
 
     TimerModule(const TimerModule&);    // make copy constructor private
     TimerModule &operator=(const TimerModule&); // prevent copy
 
-    int sunRiseSet(int year, int month, int day, double lon, double lat,
-                   double altit, int upper_limb, double *rise, double *set);
-    void sunPos(double d, double *lon, double *r);
-    void sunRadDec(double d, double *RA, double *dec, double *r);
-    double revolution(double x);
-    double rev180(double x);
-    double GMST0(double d);
+    int sunRiseSet(int year, int month, int day, float lon, float lat,
+                   float altit, int upper_limb, int16_t *rise, int16_t *set);
+    void sunDay(int year, int month, int day, float lon, sSunDay *eDay);
+    int sunRiseSet(const sSunDay &iDay, float lat, float altit, int upper_limb, int16_t *rise, int16_t *set);
+    int16_t sunNoon(const sSunDay &iDay);
 
   public:
-    struct tm mNow;
+    // local time. It was a struct tm before: tm_year + 1900 is year, tm_mon + 1 is month, tm_mday is day,
+    // tm_yday is yearDay, tm_wday is weekday, tm_hour/tm_min/tm_sec are hour/minute/second.
+    // Code which still needs a struct tm gets it with getTime().
+    sDateTime mNow;
     float mLongitude;
     float mLatitude;
-    int8_t mTimezone;
+    int8_t mTimezone = 1;
 
     TimerModule();
     ~TimerModule();
     void setup() override;
     void loop() override;
+#ifdef TIMER_DUALCORE
+    void loop1() override;
+#endif
     void debug();
 
     const std::string name() override;
     const std::string version() override;
     void processInputKo(GroupObject &ko) override;
+    void writeFlash() override;
+    void readFlash(const uint8_t *iBuffer, const uint16_t iSize) override;
+    uint16_t flashSize() override;
+    bool processCommand(const std::string iCmd, bool iDiagnoseKo) override;
+    void showHelp() override;
     
     uint8_t getDay();
     uint8_t getMonth();
@@ -125,30 +633,71 @@ class TimerModule : public OpenKNX::Module
     uint8_t getHour();
     uint8_t getMinute();
     uint8_t getSecond();
+    uint16_t getMinuteOfDay();
+    uint16_t getDayOfYear(); // 1..366
+    uint8_t getIsoWeek();
+    uint32_t getEpoch(); // seconds since 1970-01-01 UTC
+    uint32_t getMillisOfDay();
+    int64_t getEpochMillis();
+    uint32_t getMillisToNextMinute();
+    uint32_t getMillisUntil(uint8_t iHour, uint8_t iMinute, uint8_t iSecond = 0);
     uint8_t getWeekday();
     sTime *getSunInfo(uint8_t iSunInfo);
+    void getSunInfo(uint8_t iSunInfo, uint8_t iDay, uint8_t iMonth, uint16_t iYear, sTime *eSun);
     void getSunDegree(uint8_t iSunInfo, double iDegree, sTime *eSun);
+    int8_t getSunDegree(double iDegree, bool iUpperLimb, sTime *eRise, sTime *eSet);
+    void getSunTimes(const sSunAltitude *iAltitudes, uint8_t iCount, sTime (*eTimes)[2], int8_t *eRc = nullptr, sTime *eNoon = nullptr);
+    uint32_t getSunCacheHits();
+    uint32_t getSunCacheMisses();
+    void getSunPosition(float *eAzimuth, float *eElevation);
     sDay *getEaster();
     char *getTimeAsc();
+    void getTime(tm *eTime);
     bool minuteChanged(); // true every minute
     void clearMinuteChanged(); //has to be cleared externally
     void setTimeFromBus(tm *iTime);
     void setDateFromBus(tm *iDate);
     void setDateTimeFromBus(tm *iDateTime);
+    int32_t getClockDrift();  // estimated drift of the local clock in ppb
+    int32_t getClockOffset(); // offset to bus time in ms at the last time telegram
+    uint32_t getLagCount();   // number of catch-ups of a starved loop
+    uint32_t getLagMax();     // maximum lag of loop in seconds
     uint8_t holidayToday();
     uint8_t holidayTomorrow();
     bool holidayChanged();
+    uint8_t isHoliday(uint8_t iDay, uint8_t iMonth); // holiday number or 0
+    int16_t daysUntilNextHoliday(); // 0 if today is a holiday, -1 if there is none
+    void setHolidayMask(uint32_t iMask);
+    bool setHolidayRegion(uint8_t iRegion);
+    uint32_t getHolidayMask();
     void clearHolidayChanged();
     eTimeValid isTimerValid();
+    bool isTimeProvisional();
+    void getSnapshot(sTimerSnapshot *eSnapshot); // never blocks, can be called from ISR or core 1
+    int8_t addTimeEvent(uint8_t iHour, uint8_t iMinute, uint8_t iWeekdays, TimerEventCallback iCallback, void *iContext = nullptr);
+    int8_t addSunEvent(uint8_t iSunInfo, int16_t iOffset, uint8_t iWeekdays, TimerEventCallback iCallback, void *iContext = nullptr);
+    void removeEvent(uint8_t iEventId);
+#if TIMER_MAX_RULES > 0
+    int16_t addTimeRule(uint8_t iHour, uint8_t iMinute, uint8_t iWeekdays, uint16_t iMonths = TIMER_MONTHS_ALL, uint8_t iHolidays = TIMER_RULE_HOLIDAY_IGNORE);
+    int16_t addSunRule(uint8_t iSunInfo, int16_t iOffset, int16_t iEarliest, int16_t iLatest, uint8_t iWeekdays, uint16_t iMonths = TIMER_MONTHS_ALL, uint8_t iHolidays = TIMER_RULE_HOLIDAY_IGNORE);
+    void removeRule(uint16_t iRuleId);
+    bool isRuleDue(uint16_t iRuleId);
+    const uint32_t *getRulesDue(); // TIMER_RULE_WORDS words, bit (id & 31) of word (id >> 5)
+#endif
+    int8_t addChangeListener(uint8_t iChanges, TimerChangeCallback iCallback, void *iContext = nullptr);
+    void removeChangeListener(uint8_t iListenerId);
     void setIsSummertime(bool iValue);
+    int8_t addTimeSource(uint8_t iPriority, uint8_t iStratum, TimerSourceCallback iPoll = nullptr, void *iContext = nullptr);
+    void removeTimeSource(uint8_t iSourceId);
+    bool submitTime(uint8_t iSourceId, uint32_t iUtcEpoch, uint32_t iMillis);
+    int8_t getTimeSource(); // source steering the clock, -1 if none
+    uint32_t getTimeSourceRejects();
+    uint32_t getTimeSourceSwitches();
+    bool setTimezone(const char *iPosixTz);
+    void setTimezone(const sTimezoneRule &iRule);
+    int16_t getUtcOffset();
 };
 
-/* A macro to compute the number of days elapsed since 2000 Jan 0.0 */
-/* (which is equal to 1999 Dec 31, 0h UT)                           */
-
-#define days_since_2000_Jan_0(y, m, d) \
-    (367L * (y) - ((7 * ((y) + (((m) + 9) / 12))) / 4) + ((275 * (m)) / 9) + (d)-730530L)
-
 /* Some conversion factors between radians and degrees */
 
 // #ifndef PI
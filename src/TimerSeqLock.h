@@ -0,0 +1,62 @@
+#pragma once
+
+/***********************************
+ *
+ * Sequence lock for a single writer and any number of readers
+ *
+ * The value is kept twice, the sequence tells the readers which copy is
+ * not written at the moment. The writer never waits, a reader only
+ * retries if the value was written twice while it was copied. So a reader
+ * interrupting the writer (ISR) never retries, and readers on the other
+ * core of a RP2040 do not need any lock. T has to be trivially copyable.
+ *
+ * *********************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+template <typename T>
+class TimerSeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "TimerSeqLock needs a trivially copyable type");
+
+    std::atomic<uint32_t> mSequence{0}; // readers use copy (sequence & 1)
+    T mValue[2] = {};
+
+  public:
+    // must only be called by one writer
+    void write(const T &iValue)
+    {
+        uint32_t lSequence = mSequence.load(std::memory_order_relaxed);
+        // readers are sent to copy 1, while copy 0 is written and vice versa
+        mSequence.store(lSequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy((void *)&mValue[0], &iValue, sizeof(T));
+        mSequence.store(lSequence + 2, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy((void *)&mValue[1], &iValue, sizeof(T));
+    }
+
+    // false if the copy was written while reading, eValue is undefined then
+    bool tryRead(T *eValue) const
+    {
+        uint32_t lSequence = mSequence.load(std::memory_order_acquire);
+        memcpy(eValue, (const void *)&mValue[lSequence & 1], sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return mSequence.load(std::memory_order_relaxed) == lSequence;
+    }
+
+    void read(T *eValue) const
+    {
+        while (!tryRead(eValue))
+            ;
+    }
+
+    // number of writes, changes with each write
+    uint32_t version() const
+    {
+        return mSequence.load(std::memory_order_acquire) >> 1;
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+/***********************************
+ *
+ * Helpers for the host tests and benchmarks of TimerModule
+ *
+ * TestTimer opens the protected parts of TimerModule, the fake clock
+ * of the stub is moved with run(). CHECK() counts failures, a test
+ * returns testResult() from main().
+ *
+ * *********************************/
+
+#include "TimerModule.h"
+#include <cstdio>
+#include <cstdlib>
+
+static int gTestFailures = 0;
+
+#define CHECK(iCondition)                                                            \
+    do                                                                               \
+    {                                                                                \
+        if (!(iCondition))                                                           \
+        {                                                                            \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #iCondition); \
+            gTestFailures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(iActual, iExpected)                                                                           \
+    do                                                                                                         \
+    {                                                                                                          \
+        long long lActual = (long long)(iActual);                                                              \
+        long long lExpected = (long long)(iExpected);                                                          \
+        if (lActual != lExpected)                                                                              \
+        {                                                                                                      \
+            printf("%s:%d: CHECK_EQ failed: %s = %lld, expected %lld\n", __FILE__, __LINE__, #iActual, lActual, \
+                   lExpected);                                                                                 \
+            gTestFailures++;                                                                                   \
+        }                                                                                                      \
+    } while (0)
+
+inline int testResult()
+{
+    if (gTestFailures)
+        printf("%d check(s) failed\n", gTestFailures);
+    else
+        printf("all checks passed\n");
+    return gTestFailures ? 1 : 0;
+}
+
+class TestTimer : public TimerModule
+{
+  public:
+    using TimerModule::calculateHolidays;
+    using TimerModule::calculateSunriseSunset;
+    using TimerModule::mDayNumber;
+    using TimerModule::mDriftPpb;
+    using TimerModule::mEpoch;
+    using TimerModule::mEventHeapSize;
+    using TimerModule::mIsSummertime;
+    using TimerModule::mRecalc;
+    using TimerModule::processRecalc;
+    using TimerModule::sunRiseSet;
+#ifdef TIMER_SUN_TABLE
+    using TimerModule::mSunTableCount;
+    using TimerModule::mSunTableYear;
+#endif
+#if TIMER_MAX_RULES > 0
+    using TimerModule::mRulesDay;
+#endif
+
+    // sets date and time as one telegram (like DPT 19), iMonth is 1..12
+    void setBus(uint16_t iYear, uint8_t iMonth, uint8_t iDay, uint8_t iHour, uint8_t iMinute, uint8_t iSecond)
+    {
+        tm lTime = {};
+        lTime.tm_year = iYear;
+        lTime.tm_mon = iMonth;
+        lTime.tm_mday = iDay;
+        lTime.tm_hour = iHour;
+        lTime.tm_min = iMinute;
+        lTime.tm_sec = iSecond;
+        setDateTimeFromBus(&lTime);
+    }
+
+    // moves the fake clock by iMillis, loop() is called every iStep ms
+    void run(uint32_t iMillis, uint32_t iStep = 1000)
+    {
+        for (uint32_t lDone = 0; lDone < iMillis; lDone += iStep)
+        {
+            gFakeMillis += (iMillis - lDone < iStep) ? iMillis - lDone : iStep;
+            loop();
+        }
+    }
+
+    // local time as seconds of day
+    int32_t secondOfDay()
+    {
+        return getHour() * 3600L + getMinute() * 60 + getSecond();
+    }
+};
@@ -0,0 +1,146 @@
+// compiled rules of TimerModule against a naive evaluation of each rule per minute
+//
+// TIMER_MAX_RULES random rules run for 400 days. The naive evaluation uses the public getters,
+// like a logic channel checks its timer each minute. Both have to mark the same rules
+// as due. The rule work of the compiled rules is done in loop(), its cost is the time of
+// loop() against a timer without rules. The loop() calls compiling a new day are reported
+// separately.
+#include "TimerTest.h"
+#include <chrono>
+
+struct sNaiveRule
+{
+    uint8_t type;
+    int16_t minute;
+    int16_t earliest;
+    int16_t latest;
+    uint8_t weekdays;
+    uint16_t months;
+    uint8_t holidays;
+};
+
+static sNaiveRule sRules[TIMER_MAX_RULES];
+
+// fire minute of the rule today or -1, if it is not active today
+static int16_t naiveMinute(TimerModule &iTimer, const sNaiveRule &iRule)
+{
+    uint8_t lWeekday = iTimer.getWeekday();
+    if (!(iRule.months & (1 << (iTimer.getMonth() - 1))))
+        return -1;
+    bool lActive;
+    if (iTimer.holidayToday() == 0)
+        lActive = (iRule.weekdays & (1 << lWeekday)) && iRule.holidays != TIMER_RULE_HOLIDAY_ONLY;
+    else
+        lActive = iRule.holidays == TIMER_RULE_HOLIDAY_ONLY ||
+                  (iRule.holidays == TIMER_RULE_HOLIDAY_IGNORE && (iRule.weekdays & (1 << lWeekday))) ||
+                  (iRule.holidays == TIMER_RULE_HOLIDAY_SUNDAY && (iRule.weekdays & 1));
+    if (!lActive)
+        return -1;
+    int16_t lMinute = iRule.minute;
+    if (iRule.type != TIMER_EVENT_TIME)
+    {
+        sTime *lSun = iTimer.getSunInfo((iRule.type == TIMER_EVENT_SUNRISE) ? SUN_SUNRISE : SUN_SUNSET);
+        lMinute += lSun->hour * 60 + lSun->minute;
+        if (iRule.earliest >= 0 && lMinute < iRule.earliest)
+            lMinute = iRule.earliest;
+        if (iRule.latest >= 0 && lMinute > iRule.latest)
+            lMinute = iRule.latest;
+    }
+    return lMinute;
+}
+
+int main()
+{
+    srand(1);
+    TestTimer lTimer;
+    TestTimer lBase;
+    lTimer.setup();
+    lBase.setup();
+    lTimer.setHolidayRegion(TIMER_REGION_DE_BY);
+    lBase.setHolidayRegion(TIMER_REGION_DE_BY);
+    for (int i = 0; i < TIMER_MAX_RULES; i++)
+    {
+        sNaiveRule &lRule = sRules[i];
+        lRule.type = rand() % 3;
+        lRule.minute = lRule.type ? rand() % 121 - 60 : rand() % 1440;
+        lRule.earliest = (lRule.type && rand() % 2) ? rand() % 600 + 200 : -1;
+        lRule.latest = (lRule.type && rand() % 2) ? rand() % 400 + 900 : -1;
+        lRule.weekdays = rand() % 127 + 1;
+        lRule.months = (rand() % 2) ? TIMER_MONTHS_ALL : rand() % 4095 + 1;
+        lRule.holidays = rand() % 4;
+        int16_t lRuleId;
+        if (lRule.type == TIMER_EVENT_TIME)
+            lRuleId = lTimer.addTimeRule(lRule.minute / 60, lRule.minute % 60, lRule.weekdays, lRule.months, lRule.holidays);
+        else
+            lRuleId = lTimer.addSunRule((lRule.type == TIMER_EVENT_SUNRISE) ? SUN_SUNRISE : SUN_SUNSET, lRule.minute, lRule.earliest,
+                                        lRule.latest, lRule.weekdays, lRule.months, lRule.holidays);
+        CHECK_EQ(lRuleId, i);
+    }
+    lTimer.setBus(2024, 12, 20, 0, 0, 30);
+    lBase.setBus(2024, 12, 20, 0, 0, 30);
+    lTimer.run(1000);
+    lBase.run(1000);
+
+    uint32_t lMinutes = 0, lDays = 0, lFires = 0, lMismatches = 0;
+    double lNaiveNs = 0, lRulesNs = 0, lBaseNs = 0, lCompileNs = 0, lCompileMaxNs = 0;
+    int32_t lLast = lTimer.mDayNumber * 1440 + lTimer.getMinuteOfDay();
+    for (uint32_t i = 0; i < 400 * 1440; i++)
+    {
+        gFakeMillis += 60000;
+        // the second call publishes the recalculation of a new day and compiles its rules
+        for (int c = 0; c < 2; c++)
+        {
+            int32_t lRulesDay = lTimer.mRulesDay;
+            auto lStart = std::chrono::steady_clock::now();
+            lTimer.loop();
+            auto lMiddle = std::chrono::steady_clock::now();
+            lBase.loop();
+            auto lEnd = std::chrono::steady_clock::now();
+            double lRulesLoopNs = std::chrono::duration<double, std::nano>(lMiddle - lStart).count();
+            double lBaseLoopNs = std::chrono::duration<double, std::nano>(lEnd - lMiddle).count();
+            if (lTimer.mRulesDay != lRulesDay)
+            {
+                lCompileNs += lRulesLoopNs - lBaseLoopNs;
+                lCompileMaxNs = (lRulesLoopNs > lCompileMaxNs) ? lRulesLoopNs : lCompileMaxNs;
+                lDays++;
+            }
+            lRulesNs += lRulesLoopNs;
+            lBaseNs += lBaseLoopNs;
+        }
+        lMinutes++;
+        int32_t lNow = lTimer.mDayNumber * 1440 + lTimer.getMinuteOfDay();
+        int32_t lToday = lTimer.mDayNumber * 1440;
+
+        auto lStart = std::chrono::steady_clock::now();
+        // minutes skipped by the summertime switch are due with the next minute, the repeated hour is not due again
+        uint32_t lNaive[TIMER_RULE_WORDS] = {};
+        for (int r = 0; r < TIMER_MAX_RULES; r++)
+        {
+            int16_t lMinute = naiveMinute(lTimer, sRules[r]);
+            if (lMinute >= 0 && lToday + lMinute > lLast && lToday + lMinute <= lNow)
+                lNaive[r >> 5] |= 1UL << (r & 31);
+        }
+        lNaiveNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - lStart).count();
+        const uint32_t *lDue = lTimer.getRulesDue();
+        uint32_t lCount = 0;
+        for (int w = 0; w < TIMER_RULE_WORDS; w++)
+            lCount += __builtin_popcount(lDue[w]);
+
+        for (int w = 0; w < TIMER_RULE_WORDS; w++)
+        {
+            if (lNaive[w] != lDue[w] && lMismatches++ < 5)
+                printf("mismatch at %s word %d: naive %08x, compiled %08x\n", lTimer.getTimeAsc(), w, lNaive[w], lDue[w]);
+        }
+        lFires += lCount;
+        if (lNow > lLast)
+            lLast = lNow;
+    }
+    printf("%d rules, %u minutes, %u fires, %u mismatches\n", TIMER_MAX_RULES, lMinutes, lFires, lMismatches);
+    printf("naive %.1f ns/minute, rules in loop() %.1f ns/minute (loop() %.1f ns/minute, without rules %.1f ns/minute)\n",
+           lNaiveNs / lMinutes, (lRulesNs - lBaseNs) / lMinutes, lRulesNs / lMinutes, lBaseNs / lMinutes);
+    printf("compile of %u days %.1f us/day, loop() compiling a day max %.1f us\n", lDays, lCompileNs / lDays / 1000,
+           lCompileMaxNs / 1000);
+    CHECK(lDays >= 400);
+    CHECK_EQ(lMismatches, 0);
+    return testResult();
+}
@@ -0,0 +1,88 @@
+// microbenchmarks of the hot paths of TimerModule
+//
+// Reports ns per call on the host and the host cycles (x86 TSC). The estimate for a
+// Cortex-M0+ (RP2040 at 133 MHz) scales the host cycles with a rough factor for the
+// simpler core and the software floating point, it can be given as first argument.
+// It is meant to spot regressions, real numbers have to be measured on the target.
+#include "TimerTest.h"
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES() __rdtsc()
+#else
+    #define BENCH_CYCLES() 0ULL
+#endif
+
+static double sM0Factor = 12.0;
+static const double cM0Mhz = 133.0;
+static volatile int32_t sSink = 0;
+
+template <typename F>
+static void bench(const char *iName, uint32_t iCalls, F iFunction)
+{
+    // warm up caches and branch predictors
+    for (uint32_t i = 0; i < iCalls / 10 + 1; i++)
+        iFunction(i);
+    auto lStart = std::chrono::steady_clock::now();
+    unsigned long long lCycles = BENCH_CYCLES();
+    for (uint32_t i = 0; i < iCalls; i++)
+        iFunction(i);
+    lCycles = BENCH_CYCLES() - lCycles;
+    double lNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - lStart).count() / iCalls;
+    double lHostCycles = (double)lCycles / iCalls;
+    printf("%-32s %10.1f ns %10.0f cycles %10.1f us (M0+ est.)\n", iName, lNs, lHostCycles, lHostCycles * sM0Factor / cM0Mhz);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        sM0Factor = atof(argv[1]);
+    printf("M0+ estimate with factor %.1f at %.0f MHz\n", sM0Factor, cM0Mhz);
+    TestTimer lTimer;
+    lTimer.setup();
+    lTimer.setHolidayRegion(TIMER_REGION_DE_BY);
+    lTimer.setBus(2024, 6, 10, 12, 0, 0);
+
+    // loop() without a new second is the common case
+    bench("loop() idle", 1000000, [&](uint32_t) { lTimer.loop(); });
+    // loop() with the tick of one second
+    bench("loop() tick", 200000, [&](uint32_t) {
+        gFakeMillis += 1000;
+        lTimer.loop();
+    });
+    // loop() across midnight, including the daily recalculation
+    bench("loop() midnight", 2000, [&](uint32_t) {
+        lTimer.setBus(2024, 6, 10, 23, 59, 59);
+        gFakeMillis += 1000;
+        lTimer.loop();
+        lTimer.processRecalc(UINT32_MAX);
+    });
+    lTimer.setBus(2024, 6, 10, 12, 0, 0);
+    bench("calculateHolidays()", 200000, [&](uint32_t) { lTimer.calculateHolidays(); });
+    bench("calculateSunriseSunset()", 20000, [&](uint32_t i) {
+        int16_t lRise, lSet;
+        lTimer.calculateSunriseSunset(2024, 1 + i % 12, 1 + i % 28, &lRise, &lSet);
+        sSink = sSink + lRise + lSet;
+    });
+    bench("getSunDegree() cached", 200000, [&](uint32_t i) {
+        sTime lRise, lSet;
+        sSink = sSink + lTimer.getSunDegree(-6.0 - (i & 3), false, &lRise, &lSet);
+    });
+    // more altitudes than cache entries
+    bench("getSunDegree() uncached", 20000, [&](uint32_t i) {
+        sTime lRise, lSet;
+        sSink = sSink + lTimer.getSunDegree(-0.5 - (i % (2 * TIMER_SUN_CACHE_SIZE + 1)), false, &lRise, &lSet);
+    });
+    GroupObject lKo;
+    lKo.number = BASE_KoTime;
+    lKo.size = 3;
+    bench("processInputKo() time", 200000, [&](uint32_t i) {
+        uint32_t lSecond = 43200 + i % 60;
+        lKo.data[0] = (1 << 5) | (lSecond / 3600);
+        lKo.data[1] = (lSecond / 60) % 60;
+        lKo.data[2] = lSecond % 60;
+        lTimer.processInputKo(lKo);
+        gFakeMillis += TIMER_COALESCE_WINDOW;
+    });
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+/***********************************
+ *
+ * Minimal Arduino API for host builds of TimerModule
+ *
+ * millis() and micros() return the fake clock, tests move it forward
+ * to simulate the time between loop() calls.
+ *
+ * *********************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef PI
+    #define PI 3.1415926535897932384626433832795
+#endif
+
+extern uint32_t gFakeMillis;
+extern uint32_t gFakeMicros;
+
+inline uint32_t millis()
+{
+    return gFakeMillis;
+}
+
+inline uint32_t micros()
+{
+    return gFakeMicros;
+}
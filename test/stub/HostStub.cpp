@@ -0,0 +1,12 @@
+#include "OpenKNX.h"
+
+uint32_t gFakeMillis = 0;
+uint32_t gFakeMicros = 0;
+
+float gParamLongitude = 13.4f; // Berlin
+float gParamLatitude = 52.5f;
+int8_t gParamTimezone = 1;
+uint8_t gParamSummertime = 2; // VAL_STIM_FROM_INTERN
+bool gParamCombinedTimeDate = false;
+
+OpenKNX::Common openknx;
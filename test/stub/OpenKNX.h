@@ -0,0 +1,137 @@
+#pragma once
+
+/***********************************
+ *
+ * Minimal OpenKNX API for host builds of TimerModule
+ *
+ * Parameters are plain globals, so tests can change the location,
+ * the timezone or the summertime source before calling setup().
+ * Flash is a RAM buffer, console output goes to stdout.
+ *
+ * *********************************/
+
+#include "Arduino.h"
+#include <ctime>
+#include <cstdio>
+#include <string>
+
+#define MODULE_TimerModule_Version "host"
+
+extern float gParamLongitude;
+extern float gParamLatitude;
+extern int8_t gParamTimezone;
+extern uint8_t gParamSummertime;
+extern bool gParamCombinedTimeDate;
+
+#define ParamBASE_Longitude gParamLongitude
+#define ParamBASE_Latitude gParamLatitude
+#define ParamBASE_Timezone gParamTimezone
+#define ParamBASE_SummertimeAll gParamSummertime
+#define ParamBASE_CombinedTimeDate gParamCombinedTimeDate
+
+#define BASE_KoTime 1
+#define BASE_KoDate 2
+#define BASE_KoIsSummertime 3
+
+#define logInfo(iPrefix, ...) (printf("%s: ", iPrefix), printf(__VA_ARGS__), printf("\n"))
+#define logInfoP(...) (printf(__VA_ARGS__), printf("\n"))
+#define logDebugP(...) (printf(__VA_ARGS__), printf("\n"))
+#define logErrorP(...) (printf(__VA_ARGS__), printf("\n"))
+#define logIndentUp()
+#define logIndentDown()
+
+inline bool delayCheck(uint32_t iOldTimer, uint32_t iDuration)
+{
+    return millis() - iOldTimer >= iDuration;
+}
+
+struct Dpt
+{
+    Dpt(int iMain, int iSub, int iIndex = 0) {}
+};
+
+// only DPT 1 is read through value(), time and date are taken raw from valueRef()
+struct KNXValue
+{
+    bool boolValue;
+    KNXValue(bool iValue) : boolValue(iValue) {}
+    operator bool() const { return boolValue; }
+};
+
+struct GroupObject
+{
+    uint16_t number = 0;
+    uint8_t data[14] = {};
+    uint8_t size = 3;
+
+    uint16_t asap() { return number; }
+    KNXValue value(const Dpt &iDpt) { return KNXValue(data[0] != 0); }
+    uint8_t *valueRef() { return data; }
+    size_t valueSize() { return size; }
+};
+
+namespace OpenKNX
+{
+    // big endian like the OpenKNX flash api
+    struct Flash
+    {
+        uint8_t buffer[512] = {};
+        uint16_t position = 0;
+
+        void writeByte(uint8_t iValue) { buffer[position++] = iValue; }
+        void writeWord(uint16_t iValue)
+        {
+            writeByte(iValue >> 8);
+            writeByte(iValue);
+        }
+        void writeInt(uint32_t iValue)
+        {
+            writeWord(iValue >> 16);
+            writeWord(iValue);
+        }
+        uint8_t readByte() { return buffer[position++]; }
+        uint16_t readWord()
+        {
+            uint16_t lValue = readByte() << 8;
+            return lValue | readByte();
+        }
+        uint32_t readInt()
+        {
+            uint32_t lValue = (uint32_t)readWord() << 16;
+            return lValue | readWord();
+        }
+    };
+
+    struct Console
+    {
+        void printHelpLine(const char *iCommand, const char *iDescription) { printf("%-20s %s\n", iCommand, iDescription); }
+    };
+
+    struct Common
+    {
+        Flash flash;
+        Console console;
+    };
+
+    class Module
+    {
+      public:
+        virtual ~Module() {}
+        virtual const std::string name() = 0;
+        virtual const std::string version() = 0;
+        virtual void setup() {}
+        virtual void loop() {}
+        virtual void setup1() {}
+        virtual void loop1() {}
+        virtual void processInputKo(GroupObject &iKo) {}
+        virtual void writeFlash() {}
+        virtual void readFlash(const uint8_t *iBuffer, const uint16_t iSize) {}
+        virtual uint16_t flashSize() { return 0; }
+        virtual bool processCommand(const std::string iCmd, bool iDiagnoseKo) { return false; }
+        virtual void showHelp() {}
+        virtual void savePower() {}
+        virtual bool restorePower() { return true; }
+    };
+} // namespace OpenKNX
+
+extern OpenKNX::Common openknx;
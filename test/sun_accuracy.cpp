@@ -0,0 +1,131 @@
+// accuracy of SunEngine<float> and SunEngineFixed against SunEngine<double>
+//
+// Compares rise/set in UT minutes for the years 2022..2099, latitudes -66..66
+// and longitudes including the date line at -180/+180, for the altitudes of
+// rise/set and the twilights. Reports the worst error and the mismatching
+// return codes. Days, where one engine is in polar day/night and the other one
+// is not, are not counted as time error. With --check a reduced set is tested
+// against limits, which is used by ctest.
+#include "SunEngine.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct sAccuracy
+{
+    const char *name;
+    int32_t worst = 0;
+    int32_t worstYear = 0, worstMonth = 0, worstDay = 0;
+    float worstLon = 0, worstLat = 0, worstAltit = 0;
+    uint64_t sumError = 0;
+    uint32_t count = 0;
+    uint32_t rcMismatch = 0;
+};
+
+static const float cLongitudes[] = {-180.0f, -122.4f, -75.0f, -0.1f, 0.0f, 13.4f, 100.5f, 151.2f, 179.9f, 180.0f};
+static const float cAltitudes[] = {-35.0f / 60.0f, -6.0f, -12.0f, -18.0f};
+
+// tsouth near midnight may be given as 0:00 or 24:00, this is the same time
+static int32_t minuteError(int16_t iMinute, int16_t iReference)
+{
+    int32_t lError = abs(iMinute - iReference) % 1440;
+    return lError > 720 ? 1440 - lError : lError;
+}
+
+static void compare(sAccuracy &ioAccuracy, int iRcRef, int16_t iRiseRef, int16_t iSetRef, int iRc, int16_t iRise, int16_t iSet,
+                    int iYear, int iMonth, int iDay, float iLon, float iLat, float iAltit)
+{
+    if (iRc != iRcRef)
+    {
+        ioAccuracy.rcMismatch++;
+        return;
+    }
+    if (iRc != 0)
+        return;
+    int32_t lError = minuteError(iRise, iRiseRef);
+    if (minuteError(iSet, iSetRef) > lError)
+        lError = minuteError(iSet, iSetRef);
+    ioAccuracy.sumError += lError;
+    ioAccuracy.count++;
+    if (lError > ioAccuracy.worst)
+    {
+        ioAccuracy.worst = lError;
+        ioAccuracy.worstYear = iYear;
+        ioAccuracy.worstMonth = iMonth;
+        ioAccuracy.worstDay = iDay;
+        ioAccuracy.worstLon = iLon;
+        ioAccuracy.worstLat = iLat;
+        ioAccuracy.worstAltit = iAltit;
+    }
+}
+
+static void report(const sAccuracy &iAccuracy, uint32_t iCases)
+{
+    printf("%-16s worst %3d min (%04d-%02d-%02d lon %7.1f lat %5.1f altit %6.2f), mean %.3f min, rc mismatches %u of %u\n",
+           iAccuracy.name, iAccuracy.worst, iAccuracy.worstYear, iAccuracy.worstMonth, iAccuracy.worstDay, iAccuracy.worstLon,
+           iAccuracy.worstLat, iAccuracy.worstAltit, iAccuracy.count ? (double)iAccuracy.sumError / iAccuracy.count : 0.0,
+           iAccuracy.rcMismatch, iCases);
+}
+
+static int16_t toMinutes(double iHours)
+{
+    return (int16_t)std::floor(iHours * 60.0);
+}
+
+int main(int argc, char **argv)
+{
+    bool lCheck = argc > 1 && strcmp(argv[1], "--check") == 0;
+    int lDayStep = lCheck ? 5 : 1;
+    int lLatStep = lCheck ? 11 : 2;
+
+    sAccuracy lFloat, lFixed;
+    lFloat.name = "SunEngine<float>";
+    lFixed.name = "SunEngineFixed";
+    uint32_t lCases = 0;
+    int lDayIndex = 0;
+    for (int lYear = 2022; lYear <= 2099; lYear++)
+        for (int lMonth = 1; lMonth <= 12; lMonth++)
+            for (int lDay = 1; lDay <= 28; lDay++)
+            {
+                if (lDayIndex++ % lDayStep)
+                    continue;
+                for (float lLon : cLongitudes)
+                {
+                    SunEngine<double>::Day lDayRef;
+                    SunEngine<float>::Day lDayFloat;
+                    SunEngineFixed::Day lDayFixed;
+                    SunEngine<double>::sunDay(lYear, lMonth, lDay, lLon, &lDayRef);
+                    SunEngine<float>::sunDay(lYear, lMonth, lDay, lLon, &lDayFloat);
+                    SunEngineFixed::sunDay(lYear, lMonth, lDay, lLon, &lDayFixed);
+                    for (int lLatInt = -66; lLatInt <= 66; lLatInt += lLatStep)
+                        for (float lAltit : cAltitudes)
+                        {
+                            float lLat = lLatInt;
+                            int lUpperLimb = lAltit > -1.0f;
+                            double lRiseRef, lSetRef;
+                            float lRiseFloat, lSetFloat;
+                            int16_t lRiseFixed, lSetFixed;
+                            int lRcRef = SunEngine<double>::sunRiseSet(lDayRef, lLat, lAltit, lUpperLimb, &lRiseRef, &lSetRef);
+                            int lRcFloat = SunEngine<float>::sunRiseSet(lDayFloat, lLat, lAltit, lUpperLimb, &lRiseFloat, &lSetFloat);
+                            int lRcFixed = SunEngineFixed::sunRiseSet(lDayFixed, lLat, lAltit, lUpperLimb, &lRiseFixed, &lSetFixed);
+                            compare(lFloat, lRcRef, toMinutes(lRiseRef), toMinutes(lSetRef), lRcFloat, toMinutes(lRiseFloat),
+                                    toMinutes(lSetFloat), lYear, lMonth, lDay, lLon, lLat, lAltit);
+                            compare(lFixed, lRcRef, toMinutes(lRiseRef), toMinutes(lSetRef), lRcFixed, lRiseFixed, lSetFixed,
+                                    lYear, lMonth, lDay, lLon, lLat, lAltit);
+                            lCases++;
+                        }
+                }
+            }
+    report(lFloat, lCases);
+    report(lFixed, lCases);
+
+    // a date line error moves d by a day and shows up as several minutes
+    if (lCheck && (lFixed.worst > 2 || lFloat.worst > 2 || lFixed.rcMismatch > lCases / 100000 + 1 ||
+                   lFloat.rcMismatch > lCases / 100000 + 1))
+    {
+        printf("accuracy limits exceeded\n");
+        return 1;
+    }
+    return 0;
+}
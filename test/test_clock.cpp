@@ -0,0 +1,95 @@
+// clock of TimerModule against the C library over several years of ticks
+#include "TimerTest.h"
+#include <ctime>
+
+// compares the broken down fields with gmtime() of the local epoch
+static bool matches(TestTimer &iTimer)
+{
+    time_t lEpoch = iTimer.mEpoch;
+    tm lTm;
+    gmtime_r(&lEpoch, &lTm);
+    if (iTimer.getYear() == lTm.tm_year + 1900 && iTimer.getMonth() == lTm.tm_mon + 1 && iTimer.getDay() == lTm.tm_mday &&
+        iTimer.getHour() == lTm.tm_hour && iTimer.getMinute() == lTm.tm_min && iTimer.getSecond() == lTm.tm_sec &&
+        iTimer.getWeekday() == lTm.tm_wday && iTimer.getDayOfYear() == lTm.tm_yday + 1)
+        return true;
+    printf("mismatch at %s", asctime(&lTm));
+    return false;
+}
+
+// steps of one second across the end of a day, the carry of each second is done by tickSecond()
+static void testRollovers()
+{
+    static const uint16_t cDays[][3] = {
+        {2023, 1, 31}, {2023, 2, 28}, {2023, 12, 31}, {2024, 2, 28}, {2024, 2, 29}, {2024, 4, 30}, {2024, 12, 31},
+    };
+    TestTimer lTimer;
+    lTimer.setup();
+    for (const auto &lDay : cDays)
+    {
+        lTimer.setBus(lDay[0], lDay[1], lDay[2], 23, 58, 30);
+        lTimer.setBus(lDay[0], lDay[1], lDay[2], 23, 58, 30);
+        uint32_t lEpoch = lTimer.mEpoch;
+        for (int i = 1; i <= 180; i++)
+        {
+            lTimer.run(1000);
+            CHECK_EQ(lTimer.mEpoch, lEpoch + i);
+            if (!matches(lTimer))
+            {
+                gTestFailures++;
+                break;
+            }
+        }
+        CHECK_EQ(lTimer.getHour(), 0);
+        CHECK_EQ(lTimer.getMinute(), 1);
+    }
+}
+
+int main()
+{
+    testRollovers();
+
+    TestTimer lTimer;
+    lTimer.setup();
+    lTimer.setBus(2023, 12, 30, 23, 59, 0);
+    CHECK_EQ(lTimer.isTimerValid(), tmValid);
+
+    // 800 days in steps of 7 minutes, the broken down fields have to match gmtime() of the local epoch
+    int32_t lStart = lTimer.mEpoch;
+    for (uint32_t i = 1; i <= 800 * 1440 / 7; i++)
+    {
+        lTimer.run(7 * 60000, 60000);
+        time_t lExpected = lStart + i * 7 * 60L;
+        // summertime switches move the local clock
+        int32_t lShift = (int32_t)lTimer.mEpoch - (int32_t)lExpected;
+        CHECK(lShift == 0 || lShift == 3600);
+        lExpected += lShift;
+        tm lTm;
+        gmtime_r(&lExpected, &lTm);
+        if (lTimer.getYear() != lTm.tm_year + 1900 || lTimer.getMonth() != lTm.tm_mon + 1 || lTimer.getDay() != lTm.tm_mday ||
+            lTimer.getHour() != lTm.tm_hour || lTimer.getMinute() != lTm.tm_min || lTimer.getWeekday() != lTm.tm_wday ||
+            lTimer.getDayOfYear() != lTm.tm_yday + 1)
+        {
+            printf("mismatch at %s", asctime(&lTm));
+            gTestFailures++;
+            break;
+        }
+        if (lTm.tm_wday == 4 && lTm.tm_hour == 12 && lTm.tm_min < 7)
+        {
+            char lWeek[4];
+            strftime(lWeek, sizeof(lWeek), "%V", &lTm);
+            CHECK_EQ(lTimer.getIsoWeek(), atoi(lWeek));
+        }
+    }
+
+    // millisecond apis are monotonic within a second
+    uint32_t lLast = lTimer.getMillisOfDay();
+    for (int i = 0; i < 20; i++)
+    {
+        gFakeMillis += 100;
+        lTimer.loop();
+        uint32_t lNow = lTimer.getMillisOfDay();
+        CHECK(lNow > lLast || lNow < 1000);
+        lLast = lNow;
+    }
+    return testResult();
+}
@@ -0,0 +1,68 @@
+// drift learning of TimerModule: millis() runs 200 ppm fast, the bus sends its time with a resolution of 1 s
+//
+// A time telegram is sent each 10 minutes at a random phase within the second. The learned drift
+// has to stay 0 until the measurement is long enough, has to be close to 200 ppm from then on and
+// has to converge further over three days.
+#include "TimerTest.h"
+
+static const int64_t cDriftPpm = 200;
+static const int32_t cStartDay = TimerCalendar::daysFromCivil(2025, 1, 10);
+static int64_t sTrueMillis = 0; // true time since the start of the simulation
+static uint32_t sStartMillis = 0;
+
+static void advance(TestTimer &ioTimer, int64_t iMillis)
+{
+    sTrueMillis += iMillis;
+    gFakeMillis = sStartMillis + (uint32_t)(sTrueMillis + sTrueMillis * cDriftPpm / 1000000);
+    ioTimer.loop();
+}
+
+// bus time is truncated to the second, returns it in ms since the start
+static int64_t sendBus(TestTimer &ioTimer)
+{
+    int64_t lSecond = sTrueMillis / 1000;
+    int16_t lYear;
+    uint8_t lMonth, lDay;
+    TimerCalendar::civilFromDays(cStartDay + lSecond / 86400, lYear, lMonth, lDay);
+    lSecond %= 86400;
+    ioTimer.setBus(lYear, lMonth, lDay, lSecond / 3600, (lSecond / 60) % 60, lSecond % 60);
+    return sTrueMillis / 1000 * 1000;
+}
+
+int main()
+{
+    srand(1);
+    TestTimer lTimer;
+    lTimer.setup();
+    sStartMillis = gFakeMillis;
+    sendBus(lTimer);
+
+    int32_t lMaxError = 0;
+    for (uint32_t lTelegram = 1; lTelegram <= 3 * 144; lTelegram++)
+    {
+        for (int i = 0; i < 599; i++)
+            advance(lTimer, 1000);
+        int32_t lPhase = rand() % 1000;
+        advance(lTimer, lPhase);
+        int64_t lBusTime = sendBus(lTimer);
+        advance(lTimer, 1000 - lPhase);
+        int32_t lDrift = lTimer.getClockDrift();
+        if (lBusTime < TIMER_DRIFT_MIN_INTERVAL)
+        {
+            CHECK_EQ(lDrift, 0);
+            continue;
+        }
+        int32_t lError = lDrift - cDriftPpm * 1000;
+        if (lError < 0)
+            lError = -lError;
+        if (lError > lMaxError)
+            lMaxError = lError;
+    }
+    int32_t lError = lTimer.getClockDrift() - cDriftPpm * 1000;
+    printf("drift after 3 days %d ppb (error %d ppb), max error after %lld h %d ppb, clock offset %d ms\n", lTimer.getClockDrift(),
+           lError, TIMER_DRIFT_MIN_INTERVAL / 3600000, lMaxError, lTimer.getClockOffset());
+    CHECK(lMaxError < 5000);
+    CHECK(lError > -2000 && lError < 2000);
+    CHECK(lTimer.getClockOffset() > -1000 && lTimer.getClockOffset() < 1000);
+    return testResult();
+}
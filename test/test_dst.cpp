@@ -0,0 +1,86 @@
+// internal summertime switching of TimerModule: wall clock, UTC epoch, sun times of other days and the timezone configuration
+#include "TimerTest.h"
+
+// runs in steps of one second, the UTC epoch has to advance with each step
+static void runSeconds(TestTimer &ioTimer, uint32_t iSeconds, int *eWallHours)
+{
+    uint32_t lEpoch = ioTimer.getEpoch();
+    for (uint32_t i = 0; i < iSeconds; i++)
+    {
+        ioTimer.run(1000);
+        CHECK_EQ(ioTimer.getEpoch(), lEpoch + 1);
+        lEpoch = ioTimer.getEpoch();
+        eWallHours[ioTimer.getHour()]++;
+    }
+}
+
+// a timezone rule and holiday region configured before setup() are kept by it
+static void testConfigBeforeSetup()
+{
+    TestTimer lTimer;
+    CHECK(lTimer.setTimezone("EST5EDT,M3.2.0,M11.1.0"));
+    CHECK(lTimer.setHolidayRegion(TIMER_REGION_DE_BY));
+    uint32_t lMask = lTimer.getHolidayMask();
+    lTimer.setup();
+    CHECK_EQ(lTimer.getHolidayMask(), lMask);
+    CHECK(lMask != 0);
+    lTimer.setBus(2025, 1, 6, 12, 0, 0);
+    lTimer.run(1000);
+    CHECK_EQ(lTimer.getUtcOffset(), -300);
+    CHECK(lTimer.holidayToday() != 0);
+    lTimer.setBus(2025, 7, 1, 12, 0, 0);
+    lTimer.setBus(2025, 7, 1, 12, 0, 0);
+    lTimer.run(1000);
+    CHECK_EQ(lTimer.getUtcOffset(), -240);
+}
+
+int main()
+{
+    testConfigBeforeSetup();
+    TestTimer lTimer;
+    lTimer.setup();
+    int lWallHours[24] = {};
+
+    // 30.03.2025, 2:00 CET is 3:00 CEST, the wall clock never shows 2:xx
+    lTimer.setBus(2025, 3, 30, 1, 59, 0);
+    lTimer.run(1000);
+    CHECK(!lTimer.mIsSummertime);
+    runSeconds(lTimer, 3600, lWallHours);
+    CHECK(lTimer.mIsSummertime);
+    CHECK_EQ(lWallHours[2], 0);
+    CHECK_EQ(lTimer.getHour(), 3);
+    CHECK_EQ(lTimer.getMinute(), 59);
+    // a correct bus time afterwards is no step
+    lTimer.setBus(2025, 3, 30, 3, 59, 1);
+    CHECK_EQ(lTimer.getHour(), 3);
+    CHECK_EQ(lTimer.getMinute(), 59);
+
+    // 26.10.2025, 3:00 CEST is 2:00 CET, the hour 2:xx is shown twice
+    lTimer.setBus(2025, 10, 26, 1, 0, 0);
+    lTimer.setBus(2025, 10, 26, 1, 0, 0);
+    lTimer.run(1000);
+    CHECK(lTimer.mIsSummertime);
+    memset(lWallHours, 0, sizeof(lWallHours));
+    runSeconds(lTimer, 3 * 3600, lWallHours);
+    CHECK(!lTimer.mIsSummertime);
+    CHECK_EQ(lWallHours[1], 3600 - 2);
+    CHECK_EQ(lWallHours[2], 2 * 3600);
+    CHECK_EQ(lTimer.getHour(), 3);
+    // the repeated hour stays standard time
+    runSeconds(lTimer, 3600, lWallHours);
+    CHECK(!lTimer.mIsSummertime);
+    CHECK_EQ(lTimer.getHour(), 4);
+
+    // sun times of other days use the offset of that day, sunrise in Berlin on 21.06. is about 4:43 CEST
+    sTime lSunrise = {};
+    lTimer.getSunInfo(SUN_SUNRISE, 21, 6, 2025, &lSunrise);
+    CHECK_EQ(lSunrise.hour, 4);
+    lTimer.setBus(2025, 6, 21, 12, 0, 0);
+    lTimer.setBus(2025, 6, 21, 12, 0, 0);
+    lTimer.run(60000);
+    CHECK(lTimer.mIsSummertime);
+    sTime lSunriseToday = *lTimer.getSunInfo(SUN_SUNRISE);
+    CHECK_EQ(lSunriseToday.hour, lSunrise.hour);
+    CHECK_EQ(lSunriseToday.minute, lSunrise.minute);
+    return testResult();
+}
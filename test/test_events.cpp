@@ -0,0 +1,110 @@
+// events of TimerModule: removal in callbacks, steps of the clock and the summertime switch
+#include "TimerTest.h"
+
+static TestTimer sTimer;
+static int sFired[TIMER_MAX_EVENTS];
+
+static void countEvent(uint8_t iEventId, void *iContext)
+{
+    sFired[iEventId]++;
+}
+
+static void removeSelf(uint8_t iEventId, void *iContext)
+{
+    sFired[iEventId]++;
+    sTimer.removeEvent(iEventId);
+}
+
+// removes itself and takes the slot again with an event of the next minute
+static void replaceSelf(uint8_t iEventId, void *iContext)
+{
+    sFired[iEventId]++;
+    sTimer.removeEvent(iEventId);
+    CHECK_EQ(sTimer.addTimeEvent(sTimer.getHour(), sTimer.getMinute() + 1, TIMER_WEEKDAYS_ALL, countEvent), iEventId);
+}
+
+// removes itself and adds itself again
+static void readdSelf(uint8_t iEventId, void *iContext)
+{
+    sFired[iEventId]++;
+    sTimer.removeEvent(iEventId);
+    CHECK_EQ(sTimer.addTimeEvent(8, 0, TIMER_WEEKDAYS_ALL, readdSelf), iEventId);
+}
+
+// larger jumps have to be confirmed by a second telegram
+static void jump(uint16_t iYear, uint8_t iMonth, uint8_t iDay, uint8_t iHour, uint8_t iMinute, uint8_t iSecond)
+{
+    sTimer.setBus(iYear, iMonth, iDay, iHour, iMinute, iSecond);
+    sTimer.setBus(iYear, iMonth, iDay, iHour, iMinute, iSecond);
+}
+
+static void removeAll()
+{
+    for (uint8_t i = 0; i < TIMER_MAX_EVENTS; i++)
+        sTimer.removeEvent(i);
+    memset(sFired, 0, sizeof(sFired));
+}
+
+int main()
+{
+    sTimer.setup();
+    sTimer.setBus(2025, 6, 2, 6, 59, 30);
+
+    // the first of three events due in the same minute removes itself
+    int8_t lSelf = sTimer.addTimeEvent(7, 0, TIMER_WEEKDAYS_ALL, removeSelf);
+    int8_t lSecond = sTimer.addTimeEvent(7, 0, TIMER_WEEKDAYS_ALL, countEvent);
+    int8_t lThird = sTimer.addTimeEvent(7, 0, TIMER_WEEKDAYS_ALL, countEvent);
+    sTimer.run(60000);
+    CHECK_EQ(sFired[lSelf], 1);
+    CHECK_EQ(sFired[lSecond], 1);
+    CHECK_EQ(sFired[lThird], 1);
+    sTimer.run(86400000UL);
+    CHECK_EQ(sFired[lSelf], 1);
+    CHECK_EQ(sFired[lSecond], 2);
+    CHECK_EQ(sFired[lThird], 2);
+
+    // a slot taken again in the callback is queued once, for several days
+    removeAll();
+    jump(2025, 6, 4, 6, 59, 30);
+    int8_t lReplace = sTimer.addTimeEvent(7, 0, TIMER_WEEKDAYS_ALL, replaceSelf);
+    sTimer.run(120000);
+    CHECK_EQ(sFired[lReplace], 2);
+    CHECK_EQ(sTimer.mEventHeapSize, 1);
+
+    // an event adding itself again in each callback
+    removeAll();
+    int8_t lReadd = sTimer.addTimeEvent(8, 0, TIMER_WEEKDAYS_ALL, readdSelf);
+    for (int lDay = 0; lDay < 5; lDay++)
+    {
+        sTimer.run(86400000UL, 10000);
+        CHECK_EQ(sTimer.mEventHeapSize, 1);
+    }
+    CHECK_EQ(sFired[lReadd], 5);
+
+    // a step into the minute of an event still fires it, once
+    removeAll();
+    jump(2025, 6, 5, 7, 59, 30);
+    int8_t lStep = sTimer.addTimeEvent(8, 0, TIMER_WEEKDAYS_ALL, countEvent);
+    sTimer.run(12000);
+    sTimer.setBus(2025, 6, 5, 8, 0, 5);
+    sTimer.run(120000);
+    CHECK_EQ(sFired[lStep], 1);
+
+    // a small step back does not fire it again
+    sTimer.setBus(2025, 6, 5, 7, 59, 50);
+    sTimer.run(120000);
+    CHECK_EQ(sFired[lStep], 1);
+
+    // minutes around the switch to summertime, 2:00 CET is 3:00 CEST
+    removeAll();
+    jump(2025, 3, 30, 1, 58, 30);
+    int8_t lBefore = sTimer.addTimeEvent(1, 59, TIMER_WEEKDAYS_ALL, countEvent);
+    int8_t lSwitch = sTimer.addTimeEvent(2, 0, TIMER_WEEKDAYS_ALL, countEvent);
+    int8_t lAfter = sTimer.addTimeEvent(3, 0, TIMER_WEEKDAYS_ALL, countEvent);
+    sTimer.run(3 * 3600000UL);
+    CHECK(sTimer.mIsSummertime);
+    CHECK_EQ(sFired[lBefore], 1);
+    CHECK_EQ(sFired[lSwitch], 1);
+    CHECK_EQ(sFired[lAfter], 1);
+    return testResult();
+}
@@ -0,0 +1,82 @@
+// clock state of TimerModule saved with writeFlash() and restored with readFlash() through the flash stub
+#include "TimerTest.h"
+
+static int sFired = 0;
+
+static void countEvent(uint8_t iEventId, void *iContext)
+{
+    sFired++;
+}
+
+static void save(TestTimer &iTimer)
+{
+    openknx.flash.position = 0;
+    iTimer.writeFlash();
+    CHECK_EQ(openknx.flash.position, iTimer.flashSize());
+}
+
+static void restore(TestTimer &ioTimer)
+{
+    openknx.flash.position = 0;
+    ioTimer.readFlash(openknx.flash.buffer, ioTimer.flashSize());
+}
+
+int main()
+{
+    TestTimer lSaved;
+    lSaved.setup();
+    lSaved.setBus(2025, 6, 10, 11, 59, 30);
+    lSaved.run(1000);
+    lSaved.mDriftPpb = 12345;
+    CHECK_EQ(lSaved.isTimerValid(), tmValid);
+    save(lSaved);
+
+    // the restored time runs the timers, but it is reported as provisional with just the date valid
+    TestTimer lRestored;
+    lRestored.setup();
+    restore(lRestored);
+    CHECK_EQ(lRestored.isTimerValid(), tmDateValid);
+    CHECK(lRestored.isTimeProvisional());
+    CHECK_EQ(lRestored.getEpoch(), lSaved.getEpoch());
+    CHECK_EQ(lRestored.mDriftPpb, 12345);
+    CHECK(lRestored.mIsSummertime);
+    lRestored.addTimeEvent(12, 0, TIMER_WEEKDAYS_ALL, countEvent);
+    lRestored.run(60000);
+    CHECK_EQ(sFired, 1);
+    sTimerSnapshot lSnapshot;
+    lRestored.getSnapshot(&lSnapshot);
+    CHECK_EQ(lSnapshot.valid, tmDateValid);
+    CHECK(lSnapshot.provisional);
+    CHECK_EQ(lSnapshot.now.hour, 12);
+
+    // a provisional time is not saved again, just the drift
+    save(lRestored);
+    TestTimer lTwice;
+    lTwice.setup();
+    restore(lTwice);
+    CHECK_EQ(lTwice.isTimerValid(), tmInvalid);
+    CHECK(!lTwice.isTimeProvisional());
+    CHECK_EQ(lTwice.mDriftPpb, 12345);
+
+    // the first time telegram confirms the clock, 5 minutes of downtime are stepped
+    lRestored.setBus(2025, 6, 10, 12, 5, 30);
+    CHECK_EQ(lRestored.isTimerValid(), tmValid);
+    CHECK(!lRestored.isTimeProvisional());
+    CHECK_EQ(lRestored.getMinute(), 5);
+    CHECK_EQ(lRestored.getTimeSourceRejects(), 0);
+    save(lRestored);
+    restore(lTwice);
+    CHECK_EQ(lTwice.isTimerValid(), tmDateValid);
+    CHECK_EQ(lTwice.getEpoch(), lRestored.getEpoch());
+
+    // a time received before the flash is restored is kept
+    save(lSaved);
+    TestTimer lReceived;
+    lReceived.setup();
+    lReceived.setBus(2025, 6, 10, 13, 0, 0);
+    restore(lReceived);
+    CHECK_EQ(lReceived.isTimerValid(), tmValid);
+    CHECK(!lReceived.isTimeProvisional());
+    CHECK_EQ(lReceived.getHour(), 13);
+    return testResult();
+}
@@ -0,0 +1,43 @@
+// holidays of TimerModule: daysUntilNextHoliday() against the holidays seen day by day, also across the end of the year
+#include "TimerTest.h"
+
+static const int cDays = 3 * 365;
+
+static void testMask(uint32_t iMask, const char *iName)
+{
+    static uint8_t sHoliday[cDays];
+    static int16_t sUntil[cDays];
+    TestTimer lTimer;
+    lTimer.setup();
+    lTimer.setHolidayMask(iMask);
+    lTimer.setBus(2024, 1, 1, 12, 0, 0);
+    lTimer.run(1000);
+    for (int i = 0; i < cDays; i++)
+    {
+        sHoliday[i] = lTimer.holidayToday();
+        sUntil[i] = lTimer.daysUntilNextHoliday();
+        lTimer.run(86400000UL, 600000);
+    }
+    // the last year is just the lookahead of the others
+    uint32_t lMismatches = 0;
+    for (int i = 0; i < cDays - 366; i++)
+    {
+        int lNext = i;
+        while (!sHoliday[lNext])
+            lNext++;
+        if (sUntil[i] != lNext - i && lMismatches++ < 5)
+            printf("%s: day %d, %d days until the next holiday, expected %d\n", iName, i, sUntil[i], lNext - i);
+    }
+    CHECK_EQ(lMismatches, 0);
+}
+
+int main()
+{
+    // just easter monday, so it is on another day each year
+    testMask(0x80000000UL >> (11 - 1), "easter monday");
+    testMask(0x80000000UL >> (11 - 1) | 0x80000000UL >> (1 - 1), "new year and easter monday");
+    TestTimer lRegion;
+    CHECK(lRegion.setHolidayRegion(TIMER_REGION_DE_BY));
+    testMask(lRegion.getHolidayMask(), "DE-BY");
+    return testResult();
+}
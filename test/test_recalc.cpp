@@ -0,0 +1,78 @@
+// daily recalculation of TimerModule, built with and without TIMER_DUALCORE
+//
+// The timer under test recalculates step by step within loop(), with TIMER_DUALCORE
+// a std::thread plays core 1 and calls loop1(). Each day its published holidays and
+// sunrise have to match a reference timer, which recalculates at once. The latency
+// of loop() across midnight is reported, compare both builds to see the offload.
+#include "TimerTest.h"
+#include <atomic>
+#include <chrono>
+#ifdef TIMER_DUALCORE
+    #include <thread>
+#endif
+
+static const int cDays = 400;
+
+int main()
+{
+    TestTimer lTimer;
+    TestTimer lReference;
+    lTimer.setup();
+    lReference.setup();
+    lTimer.setHolidayRegion(TIMER_REGION_DE_BY);
+    lReference.setHolidayRegion(TIMER_REGION_DE_BY);
+    lTimer.setBus(2024, 12, 20, 23, 59, 58);
+    lReference.setBus(2024, 12, 20, 23, 59, 58);
+
+#ifdef TIMER_DUALCORE
+    std::atomic<bool> lStop{false};
+    std::thread lCore1([&] {
+        while (!lStop)
+            lTimer.loop1();
+    });
+    const char *lBuild = "dual core";
+#else
+    const char *lBuild = "single core";
+#endif
+
+    double lMaxUs = 0, lSumUs = 0;
+    uint32_t lCalls = 0;
+    for (int lDay = 0; lDay < cDays; lDay++)
+    {
+        // through midnight
+        for (int i = 0; i < 3; i++)
+        {
+            gFakeMillis += 1000;
+            auto lStart = std::chrono::steady_clock::now();
+            lTimer.loop();
+            double lUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - lStart).count();
+            lMaxUs = (lUs > lMaxUs) ? lUs : lMaxUs;
+            lSumUs += lUs;
+            lCalls++;
+            lReference.loop();
+        }
+        lReference.processRecalc(UINT32_MAX);
+        // idle loops until the new day is published
+        auto lTimeout = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (lTimer.mRecalc.step != TIMER_RECALC_IDLE && std::chrono::steady_clock::now() < lTimeout)
+            lTimer.loop();
+        CHECK_EQ(lTimer.mRecalc.step, TIMER_RECALC_IDLE);
+        CHECK_EQ(lTimer.getDay(), lReference.getDay());
+        CHECK_EQ(lTimer.holidayToday(), lReference.holidayToday());
+        CHECK_EQ(lTimer.holidayTomorrow(), lReference.holidayTomorrow());
+        CHECK_EQ(lTimer.getSunInfo(SUN_SUNRISE)->hour, lReference.getSunInfo(SUN_SUNRISE)->hour);
+        CHECK_EQ(lTimer.getSunInfo(SUN_SUNRISE)->minute, lReference.getSunInfo(SUN_SUNRISE)->minute);
+        CHECK_EQ(lTimer.getSunInfo(SUN_SUNSET)->minute, lReference.getSunInfo(SUN_SUNSET)->minute);
+        // to 2 seconds before the next midnight
+        gFakeMillis += 86397000;
+        lTimer.loop();
+        lReference.loop();
+    }
+
+#ifdef TIMER_DUALCORE
+    lStop = true;
+    lCore1.join();
+#endif
+    printf("%s: loop() across midnight max %.1f us, avg %.2f us over %d days\n", lBuild, lMaxUs, lSumUs / lCalls, cDays);
+    return testResult();
+}
@@ -0,0 +1,83 @@
+// snapshot of TimerModule read by a second thread, the date is held back during the recalculation
+//
+// Built with TIMER_RECALC_BUDGET 0, so the recalculation takes several loop() calls.
+#include "TimerTest.h"
+#include <atomic>
+#include <thread>
+
+static const int cDays = 60;
+
+int main()
+{
+    TestTimer lTimer;
+    lTimer.setup();
+    lTimer.setHolidayRegion(TIMER_REGION_DE_BY);
+    lTimer.setBus(2024, 12, 20, 23, 59, 55);
+    lTimer.run(1000);
+    while (lTimer.mRecalc.step != TIMER_RECALC_IDLE)
+        lTimer.loop();
+
+    // date of the snapshot before the recalculation of the new day is published
+    gFakeMillis += 5000;
+    lTimer.loop();
+    CHECK(lTimer.mRecalc.step != TIMER_RECALC_IDLE);
+    CHECK_EQ(lTimer.getDay(), 21);
+    sTimerSnapshot lSnapshot;
+    lTimer.getSnapshot(&lSnapshot);
+    CHECK_EQ(lSnapshot.now.day, 20);
+    while (lTimer.mRecalc.step != TIMER_RECALC_IDLE)
+        lTimer.loop();
+    lTimer.getSnapshot(&lSnapshot);
+    CHECK_EQ(lSnapshot.now.day, 21);
+    CHECK_EQ(lSnapshot.now.second, 1);
+    CHECK_EQ(lSnapshot.holidayToday, lTimer.holidayToday());
+    CHECK_EQ(lSnapshot.sunrise.minute, lTimer.getSunInfo(SUN_SUNRISE)->minute);
+
+    // the reader checks time fields against the epoch and that a date has always the same holidays and sunrise
+    std::atomic<bool> lStop{false};
+    std::atomic<uint32_t> lReads{0}, lBad{0};
+    std::thread lReader([&] {
+        int32_t lDayNumber = -1;
+        uint8_t lHoliday = 0, lTomorrow = 0;
+        uint16_t lSunrise = 0;
+        while (!lStop)
+        {
+            sTimerSnapshot lRead;
+            lTimer.getSnapshot(&lRead);
+            lReads++;
+            uint32_t lLocal = lRead.epoch + lRead.utcOffset * 60L;
+            int16_t lYear;
+            uint8_t lMonth, lDay;
+            TimerCalendar::civilFromDays(lLocal / 86400, lYear, lMonth, lDay);
+            if (lYear != lRead.now.year || lMonth != lRead.now.month || lDay != lRead.now.day ||
+                lLocal % 86400 != lRead.now.hour * 3600UL + lRead.now.minute * 60 + lRead.now.second)
+                lBad++;
+            uint16_t lReadSunrise = lRead.sunrise.hour * 60 + lRead.sunrise.minute;
+            if ((int32_t)(lLocal / 86400) == lDayNumber)
+            {
+                if (lRead.holidayToday != lHoliday || lRead.holidayTomorrow != lTomorrow || lReadSunrise != lSunrise)
+                    lBad++;
+            }
+            lDayNumber = lLocal / 86400;
+            lHoliday = lRead.holidayToday;
+            lTomorrow = lRead.holidayTomorrow;
+            lSunrise = lReadSunrise;
+        }
+    });
+    for (int lDay = 0; lDay < cDays; lDay++)
+    {
+        for (int i = 0; i < 20; i++)
+        {
+            gFakeMillis += 250;
+            lTimer.loop();
+            std::this_thread::yield();
+        }
+        gFakeMillis += 86395000;
+        lTimer.loop();
+    }
+    lStop = true;
+    lReader.join();
+    printf("%u snapshots read, %u inconsistent\n", lReads.load(), lBad.load());
+    CHECK_EQ(lBad.load(), 0);
+    return testResult();
+}
@@ -0,0 +1,137 @@
+// time sources of TimerModule: summertime switch of the bus, outliers and convergence to a better source
+#include "TimerTest.h"
+
+// true UTC time of the simulation in ms, the error of the RTC is added to its time
+static int64_t sTrueMillis = 1718000000000LL; // 10.06.2024 06:13:20 UTC
+static int64_t sRtcError = 0;
+
+static bool pollRtc(uint32_t *eUtcEpoch, void *iContext)
+{
+    *eUtcEpoch = (sTrueMillis + sRtcError) / 1000;
+    return true;
+}
+
+// DPT 19 telegram through the group object
+static void sendDpt19(TestTimer &ioTimer, uint16_t iYear, uint8_t iMonth, uint8_t iDay, uint8_t iHour, uint8_t iMinute,
+                      uint8_t iSecond, bool iSummertime)
+{
+    GroupObject lKo;
+    lKo.number = BASE_KoTime;
+    lKo.size = 8;
+    lKo.data[0] = iYear - 1900;
+    lKo.data[1] = iMonth;
+    lKo.data[2] = iDay;
+    lKo.data[3] = iHour;
+    lKo.data[4] = iMinute;
+    lKo.data[5] = iSecond;
+    lKo.data[6] = DPT19_NO_DAY_OF_WEEK | (iSummertime ? DPT19_SUMMERTIME : 0);
+    ioTimer.processInputKo(lKo);
+}
+
+// the bus sends the summertime switch with DPT 19, the clock of the module is a few seconds behind
+static void testSummertimeSwitch()
+{
+    gParamCombinedTimeDate = true;
+    gParamSummertime = VAL_STIM_FROM_DPT19;
+    TestTimer lTimer;
+    lTimer.setup();
+
+    sendDpt19(lTimer, 2025, 3, 30, 1, 59, 0, false);
+    lTimer.run(50000);
+    CHECK_EQ(lTimer.secondOfDay(), 1 * 3600 + 59 * 60 + 50);
+    uint32_t lEpoch = lTimer.getEpoch();
+    sendDpt19(lTimer, 2025, 3, 30, 3, 0, 15, true);
+    CHECK_EQ(lTimer.getTimeSourceRejects(), 0);
+    CHECK(lTimer.mIsSummertime);
+    CHECK_EQ(lTimer.secondOfDay(), 3 * 3600 + 15);
+    CHECK_EQ(lTimer.getEpoch(), lEpoch + 25);
+
+    // end of summertime, confirmed as the time is far away from the clock
+    sendDpt19(lTimer, 2025, 10, 26, 2, 59, 50, true);
+    sendDpt19(lTimer, 2025, 10, 26, 2, 59, 50, true);
+    CHECK_EQ(lTimer.getTimeSourceRejects(), 1);
+    lTimer.run(10000);
+    sendDpt19(lTimer, 2025, 10, 26, 2, 0, 5, false);
+    CHECK_EQ(lTimer.getTimeSourceRejects(), 1);
+    CHECK(!lTimer.mIsSummertime);
+    CHECK_EQ(lTimer.secondOfDay(), 2 * 3600 + 5);
+
+    // the same jump far away from a transition is an outlier
+    lTimer.run(3600000);
+    sendDpt19(lTimer, 2025, 10, 26, 4, 0, 5, false);
+    CHECK_EQ(lTimer.getTimeSourceRejects(), 2);
+    CHECK_EQ(lTimer.secondOfDay(), 3 * 3600 + 5);
+
+    gParamCombinedTimeDate = false;
+    gParamSummertime = VAL_STIM_FROM_INTERN;
+}
+
+// sends the local time of the bus, two masters differ by iSkew
+static void sendBus(TestTimer &ioTimer, int32_t iSkew)
+{
+    int64_t lLocal = sTrueMillis + 2 * 3600000LL + iSkew;
+    int32_t lSecond = (lLocal / 1000) % 86400;
+    tm lTime = {};
+    lTime.tm_hour = lSecond / 3600;
+    lTime.tm_min = (lSecond / 60) % 60;
+    lTime.tm_sec = lSecond % 60;
+    ioTimer.setTimeFromBus(&lTime);
+}
+
+// runs one second, millis() is 200 ppm fast
+static void tick(TestTimer &ioTimer, uint32_t iSecond)
+{
+    sTrueMillis += 1000;
+    gFakeMillis += (iSecond % 5 == 0) ? 1001 : 1000;
+    ioTimer.loop();
+}
+
+// two bus masters disagree by 1.5 s, then an RTC with better priority takes over
+static void testConvergence()
+{
+    TestTimer lTimer;
+    lTimer.setup();
+    tm lDate = {};
+    lDate.tm_year = 2024;
+    lDate.tm_mon = 6;
+    lDate.tm_mday = 10;
+    lTimer.setDateFromBus(&lDate);
+    for (uint32_t i = 0; i < 36000; i++)
+    {
+        tick(lTimer, i);
+        if (i % 600 == 0)
+            sendBus(lTimer, (i / 600) % 2 ? 1500 : 0);
+    }
+    CHECK_EQ(lTimer.getTimeSource(), TIMER_SOURCE_BUS);
+    CHECK(lTimer.getClockOffset() > -2000 && lTimer.getClockOffset() < 2000);
+
+    int8_t lRtc = lTimer.addTimeSource(50, 1, pollRtc);
+    CHECK(lRtc > 0);
+    int32_t lConverged = -1;
+    for (uint32_t i = 0; i < 36000; i++)
+    {
+        tick(lTimer, i);
+        if (i % 600 == 0)
+            sendBus(lTimer, (i / 600) % 2 ? 1500 : 0);
+        // the RTC jumps by an hour, rejected once, then confirmed
+        if (i == 18000)
+            sRtcError = 3600000;
+        int64_t lError = lTimer.getEpochMillis() - (sTrueMillis + sRtcError);
+        if (lConverged < 0 && lError < 1000 && lError > -1000 && lTimer.getTimeSource() == lRtc)
+            lConverged = i;
+    }
+    printf("convergence to the RTC after %d s, %u switches, %u rejects\n", lConverged, lTimer.getTimeSourceSwitches(),
+           lTimer.getTimeSourceRejects());
+    CHECK(lConverged >= 0 && lConverged <= 2 * TIMER_SOURCE_POLL / 1000);
+    CHECK_EQ(lTimer.getTimeSource(), lRtc);
+    CHECK_EQ(lTimer.getTimeSourceRejects(), 1);
+    int64_t lError = lTimer.getEpochMillis() - (sTrueMillis + sRtcError);
+    CHECK(lError < 1000 && lError > -1000);
+}
+
+int main()
+{
+    testSummertimeSwitch();
+    testConvergence();
+    return testResult();
+}
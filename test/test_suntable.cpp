@@ -0,0 +1,78 @@
+// sun table of TimerModule (TIMER_SUN_TABLE): filled one day per idle loop, lookups match sunRiseSet()
+#include "TimerTest.h"
+
+// sunrise/sunset of each day of the year through calculateSunriseSunset() against sunRiseSet()
+static void compareYear(TestTimer &iTimer, int16_t iYear)
+{
+    int32_t lFirst = TimerCalendar::daysFromCivil(iYear, 1, 1);
+    uint32_t lMismatches = 0;
+    for (uint16_t i = 0; i < TimerCalendar::daysInYear(iYear); i++)
+    {
+        int16_t lYear;
+        uint8_t lMonth, lDay;
+        TimerCalendar::civilFromDays(lFirst + i, lYear, lMonth, lDay);
+        int16_t lRise, lSet, lDirectRise, lDirectSet;
+        iTimer.calculateSunriseSunset(lYear, lMonth, lDay, &lRise, &lSet);
+        iTimer.sunRiseSet(lYear, lMonth, lDay, iTimer.mLongitude, iTimer.mLatitude, -35.0f / 60.0f, 1, &lDirectRise, &lDirectSet);
+        if ((lRise != lDirectRise || lSet != lDirectSet) && lMismatches++ < 5)
+            printf("mismatch on %02d.%02d.%d: table %d/%d, direct %d/%d\n", lDay, lMonth, lYear, lRise, lSet, lDirectRise, lDirectSet);
+    }
+    CHECK_EQ(lMismatches, 0);
+}
+
+// idle loops, the time does not advance
+static void idle(TestTimer &ioTimer, uint32_t iLoops)
+{
+    for (uint32_t i = 0; i < iLoops; i++)
+        ioTimer.loop();
+}
+
+int main()
+{
+    TestTimer lTimer;
+    lTimer.setup();
+    lTimer.setBus(2024, 1, 1, 12, 0, 0);
+    lTimer.run(1000);
+    idle(lTimer, 1);
+    CHECK_EQ(lTimer.mRecalc.step, TIMER_RECALC_IDLE);
+    CHECK_EQ(lTimer.mSunTableYear, 2024);
+
+    // one day per idle loop, days not yet in the table are calculated directly
+    uint16_t lCount = lTimer.mSunTableCount;
+    idle(lTimer, 1);
+    CHECK_EQ(lTimer.mSunTableCount, lCount + 1);
+    compareYear(lTimer, 2024);
+    idle(lTimer, 400);
+    CHECK_EQ(lTimer.mSunTableCount, 366);
+    compareYear(lTimer, 2024);
+
+    // a loop with a tick does not fill the table
+    lCount = lTimer.mSunTableCount;
+    lTimer.run(1000);
+    CHECK_EQ(lTimer.mSunTableCount, lCount);
+
+    // a new location starts the table again
+    lTimer.mLongitude = 11.58f;
+    lTimer.mLatitude = 48.14f;
+    idle(lTimer, 1);
+    CHECK_EQ(lTimer.mSunTableCount, 1);
+    compareYear(lTimer, 2024);
+    idle(lTimer, 400);
+    CHECK_EQ(lTimer.mSunTableCount, 366);
+    compareYear(lTimer, 2024);
+
+    // and so does a new year, other years are calculated directly
+    lTimer.setBus(2025, 3, 1, 12, 0, 0);
+    lTimer.setBus(2025, 3, 1, 12, 0, 0);
+    lTimer.run(1000);
+    idle(lTimer, 400);
+    CHECK_EQ(lTimer.mSunTableYear, 2025);
+    CHECK_EQ(lTimer.mSunTableCount, 365);
+    compareYear(lTimer, 2025);
+    compareYear(lTimer, 2024);
+    int16_t lRise, lSet;
+    lTimer.calculateSunriseSunset(2025, 3, 1, &lRise, &lSet);
+    sTime lSunrise = *lTimer.getSunInfo(SUN_SUNRISE);
+    CHECK_EQ(lSunrise.hour * 60 + lSunrise.minute, (lRise + lTimer.getUtcOffset() + 1440) % 1440);
+    return testResult();
+}